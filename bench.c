@@ -0,0 +1,192 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include "frontier.h"
+#include "grid.h"
+#include "perf_counters.h"
+#include "topology.h"
+#include "trie.h"
+#include "word_finder.h"
+
+#define DEFAULT_MIN_SIZE 5
+#define DEFAULT_MAX_SIZE 12
+#define DEFAULT_MAX_SWAPS 2
+#define DEFAULT_BOARDS 3
+#define DEFAULT_MAX_WORD_LENGTH 14
+#define DEFAULT_DICT_FILE "resources/dictionary.txt"
+
+typedef enum { ENGINE_DFS, ENGINE_FRONTIER, ENGINE_NUMA, NUM_ENGINES } Engine;
+
+static const char *ENGINE_NAMES[NUM_ENGINES] = {"dfs", "frontier", "numa"};
+
+static double elapsedMs(const struct timespec *start, const struct timespec *end) {
+	return (end->tv_sec - start->tv_sec) * 1e3 + (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+// Random letters with one double letter and one double word tile, like a real board
+static void randomizeGrid(Grid *grid, uint64_t *rng) {
+	int numCells = grid->size * grid->size;
+	for (int i = 0; i < numCells; i++) {
+		grid->letters[i] = randomGridLetter(rng);
+		grid->letterMultiplier[i] = 1;
+		grid->wordMultiplier[i] = 1;
+	}
+	grid->letterMultiplier[randomGridCell(grid, rng)] = 2;
+	grid->wordMultiplier[randomGridCell(grid, rng)] = 2;
+}
+
+int main(int argc, char *argv[]) {
+	int minSize = DEFAULT_MIN_SIZE;
+	int maxSize = DEFAULT_MAX_SIZE;
+	int maxSwaps = DEFAULT_MAX_SWAPS;
+	int boards = DEFAULT_BOARDS;
+	int maxWordLength = DEFAULT_MAX_WORD_LENGTH;
+	char *dictFile = DEFAULT_DICT_FILE;
+	char *engine = "dfs";
+	bool perf = false;
+
+	int opt;
+	static struct option longOptions[] = {
+		{"minsize", required_argument, 0, 'm'},
+		{"maxsize", required_argument, 0, 'M'},
+		{"maxswaps", required_argument, 0, 's'},
+		{"boards", required_argument, 0, 'b'},
+		{"maxwordlength", required_argument, 0, 'w'},
+		{"dict", required_argument, 0, 'd'},
+		{"engine", required_argument, 0, 'e'},
+		{"memo", required_argument, 0, 'r'},
+		{"perf", required_argument, 0, 'p'},
+		{0, 0, 0, 0}
+	};
+
+	while ((opt = getopt_long(argc, argv, "m:M:s:b:w:d:e:r:p:", longOptions, NULL)) != -1) {
+		switch (opt) {
+			case 'm': minSize = atoi(optarg); break;
+			case 'M': maxSize = atoi(optarg); break;
+			case 's': maxSwaps = atoi(optarg); break;
+			case 'b': boards = atoi(optarg); break;
+			case 'w': maxWordLength = atoi(optarg); break;
+			case 'd': dictFile = optarg; break;
+			case 'e': engine = optarg; break;
+			case 'r': setReachabilityMemo(strcmp(optarg, "true") == 0); break;
+			case 'p': perf = (strcmp(optarg, "true") == 0); break;
+			default:
+				fprintf(stderr, "Usage: %s [--minsize n] [--maxsize n] [--maxswaps n] [--boards n] [--maxwordlength n] [--dict file] [--engine dfs,frontier,numa] [--memo true|false] [--perf true|false]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if (maxSwaps < 0 || maxSwaps > MAX_SWAPS) {
+		fprintf(stderr, "--maxswaps must be between 0 and %d\n", MAX_SWAPS);
+		return 1;
+	}
+
+	// A comma-separated list of engines to time on the same boards
+	bool runEngine[NUM_ENGINES] = {false};
+	for (char *name = strtok(engine, ","); name != NULL; name = strtok(NULL, ",")) {
+		int e = 0;
+		while (e < NUM_ENGINES && strcmp(name, ENGINE_NAMES[e]) != 0)
+			e++;
+		if (e == NUM_ENGINES) {
+			fprintf(stderr, "Unknown engine: %s\n", name);
+			return 1;
+		}
+		runEngine[e] = true;
+	}
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	TrieNode *trie = loadDictionary(dictFile, maxWordLength);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("# dictionary load: %.1f ms\n", elapsedMs(&start, &end));
+
+	// Threads are pinned for every engine, so numa and dfs differ only in the replication
+	TrieReplicas *replicas = NULL;
+	if (runEngine[ENGINE_NUMA]) {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		replicas = createTrieReplicas(trie, true);
+		pinSearchThreads(replicas);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		printf("# %d NUMA node(s), %s, replication: %.1f ms\n", replicas->numNodes,
+			   replicas->replicated ? "one replica per node" : "shared trie", elapsedMs(&start, &end));
+	}
+	// Counters are opened after pinning, so each search thread counts itself
+	PerfCounters *counters = perf ? openPerfCounters() : NULL;
+
+	printf("%-9s %-6s %-6s %-7s %-10s %-10s %-12s %-10s", "engine", "size", "swaps", "boards", "mean_ms", "max_ms",
+		   "boards_per_s", "maxrss_mb");
+	for (int p = 0; counters != NULL && p < NUM_PERF_EVENTS; p++) {
+		printf(" %-14s", PERF_EVENT_NAMES[p]);
+	}
+	printf("\n");
+
+	for (int size = minSize; size <= maxSize; size++) {
+		for (int swaps = 0; swaps <= maxSwaps; swaps++) {
+			for (int e = 0; e < NUM_ENGINES; e++) {
+				if (!runEngine[e])
+					continue;
+
+				// Every engine sees the same boards for a given size and swap count
+				Grid *grid = createGrid(size);
+				uint64_t rng = size * 1000 + swaps;
+				double totalMs = 0;
+				double maxMs = 0;
+				PerfSample perfTotal = {0};
+
+				for (int b = 0; b < boards; b++) {
+					randomizeGrid(grid, &rng);
+					if (counters != NULL)
+						beginPerfPhase(counters);
+					clock_gettime(CLOCK_MONOTONIC, &start);
+					WordResult *bestResults;
+					if (e == ENGINE_FRONTIER)
+						bestResults = findBestResultsFrontier(grid, trie, maxWordLength, swaps);
+					else if (e == ENGINE_NUMA)
+						bestResults = findBestResultsReplicated(grid, replicas, maxWordLength, swaps);
+					else
+						bestResults = findBestResults(grid, trie, maxWordLength, swaps);
+					clock_gettime(CLOCK_MONOTONIC, &end);
+					if (counters != NULL) {
+						PerfSample sample = endPerfPhase(counters);
+						for (int p = 0; p < NUM_PERF_EVENTS; p++) {
+							perfTotal.available[p] = sample.available[p];
+							perfTotal.totals[p] += sample.totals[p];
+						}
+					}
+					freeBestResults(bestResults, swaps);
+
+					double ms = elapsedMs(&start, &end);
+					totalMs += ms;
+					if (ms > maxMs)
+						maxMs = ms;
+				}
+
+				struct rusage usage;
+				getrusage(RUSAGE_SELF, &usage);
+				printf("%-9s %-6d %-6d %-7d %-10.1f %-10.1f %-12.1f %-10.1f", ENGINE_NAMES[e], size, swaps, boards,
+					   totalMs / boards, maxMs, boards * 1000.0 / totalMs, usage.ru_maxrss / 1024.0);
+				// Mean per board, or - where the event is unavailable
+				for (int p = 0; counters != NULL && p < NUM_PERF_EVENTS; p++) {
+					if (perfTotal.available[p])
+						printf(" %-14llu", (unsigned long long)(perfTotal.totals[p] / boards));
+					else
+						printf(" %-14s", "-");
+				}
+				printf("\n");
+				fflush(stdout);
+				freeGrid(grid);
+			}
+		}
+	}
+
+	if (counters != NULL)
+		closePerfCounters(counters);
+	if (replicas != NULL)
+		freeTrieReplicas(replicas);
+	freeThreadScratch();
+	freeTrie(trie);
+	return 0;
+}
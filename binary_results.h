@@ -0,0 +1,118 @@
+#ifndef BINARY_RESULTS_H
+#define BINARY_RESULTS_H
+
+/*
+ * Layout of the --format bin output, and a reader that needs no parsing.
+ *
+ * This header is self-contained so that consumers can copy it into their own
+ * projects. A result set is a BinaryResultsHeader, numRecords fixed-width records
+ * and a string table of NUL-terminated words, in the writer's byte order. There is
+ * no byte-order marker: the magic reads the same everywhere, but a reader of the
+ * other byte order sees version 256 and rejects the set. Batch runs write one
+ * result set per grid back to back; totalSize is padded to 8 bytes so that every
+ * set stays aligned in a buffer or an mmap()ed file.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define BINARY_RESULTS_MAGIC "SCRB"
+#define BINARY_RESULTS_VERSION 1
+
+typedef struct {
+	char magic[4];          // BINARY_RESULTS_MAGIC
+	uint16_t version;       // BINARY_RESULTS_VERSION
+	uint16_t headerSize;    // Offset of the first record
+	uint32_t totalSize;     // Size of the whole result set, including padding
+	uint32_t numRecords;    // numLists * (maxSwaps + 1), list by list
+	uint16_t recordSize;    // Distance between two records
+	uint8_t cellSlots;      // Cells stored per record, the length of the longest word
+	uint8_t swapSlots;      // Swap cells stored per record
+	uint8_t gridSize;
+	uint8_t numLists;
+	uint16_t maxSwaps;
+	uint32_t stringsOffset; // Offset of the string table
+	uint32_t stringsSize;
+} BinaryResultsHeader;
+
+typedef struct {
+	uint16_t score;
+	uint8_t swaps;          // Swap count this record is the best word for
+	uint8_t length;         // Letters in the word, 0 if no word was found
+	uint8_t list;           // Index of the word list (0 with a single dictionary)
+	uint8_t numSwaps;       // Swap cells actually used
+	uint16_t reserved;
+	uint32_t wordOffset;    // Offset of the word in the string table
+	uint16_t cells[];       // cellSlots cells (row * gridSize + col), then swapSlots swap cells
+} BinaryResultRecord;
+
+/**
+ * Checks that a buffer starts with a complete result set this reader understands.
+ *
+ * @param data The buffer, aligned to 8 bytes.
+ * @param size The size of the buffer.
+ * @return The header of the result set, or NULL if the buffer does not hold one.
+ */
+static inline const BinaryResultsHeader* binaryResultsHeader(const void *data, size_t size) {
+	const BinaryResultsHeader *header = data;
+	if (size < sizeof(BinaryResultsHeader) || memcmp(header->magic, BINARY_RESULTS_MAGIC, 4) != 0 ||
+		header->version != BINARY_RESULTS_VERSION || header->headerSize < sizeof(BinaryResultsHeader) ||
+		header->totalSize < header->headerSize || header->totalSize % 8 != 0 || header->totalSize > size ||
+		header->recordSize < sizeof(BinaryResultRecord) + (header->cellSlots + header->swapSlots) * sizeof(uint16_t) ||
+		header->headerSize + (size_t)header->numRecords * header->recordSize > header->stringsOffset ||
+		(size_t)header->stringsOffset + header->stringsSize > header->totalSize)
+		return NULL;
+	return header;
+}
+
+/**
+ * Returns the result set following this one in a batch output.
+ *
+ * @param header The current result set.
+ * @param size The size of the buffer starting at header.
+ * @return The next result set, or NULL at the end of the buffer.
+ */
+static inline const BinaryResultsHeader* nextBinaryResults(const BinaryResultsHeader *header, size_t size) {
+	return binaryResultsHeader((const char *)header + header->totalSize, size - header->totalSize);
+}
+
+/**
+ * Returns a record of a result set.
+ *
+ * @param header The result set.
+ * @param index The record index (list * (maxSwaps + 1) + swaps), below numRecords.
+ * @return The record.
+ */
+static inline const BinaryResultRecord* binaryResultRecord(const BinaryResultsHeader *header, uint32_t index) {
+	return (const BinaryResultRecord *)((const char *)header + header->headerSize + (size_t)index * header->recordSize);
+}
+
+/**
+ * Returns the word of a record.
+ *
+ * @param header The result set.
+ * @param record One of its records.
+ * @return The NUL-terminated word, empty if no word was found, or NULL if the record
+ *         points outside the string table.
+ */
+static inline const char* binaryResultWord(const BinaryResultsHeader *header, const BinaryResultRecord *record) {
+	const char *strings = (const char *)header + header->stringsOffset;
+	if ((size_t)record->wordOffset + record->length >= header->stringsSize ||
+		strings[record->wordOffset + record->length] != '\0')
+		return NULL;
+	return strings + record->wordOffset;
+}
+
+/**
+ * Returns the swap cells of a record; its path is record->cells[0 .. length).
+ *
+ * @param header The result set.
+ * @param record One of its records.
+ * @return The numSwaps swapped cells.
+ */
+static inline const uint16_t* binaryResultSwapCells(const BinaryResultsHeader *header, const BinaryResultRecord *record) {
+	return record->cells + header->cellSlots;
+}
+
+#endif // BINARY_RESULTS_H
@@ -0,0 +1,326 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "cache.h"
+
+#define CACHE_MAGIC "SCRC"
+#define CACHE_VERSION 1
+#define CACHE_SUFFIX ".scr"
+#define TEMP_PREFIX ".tmp-"
+// Temporary entries older than this were left behind by a writer that crashed before renaming them
+#define STALE_TEMP_SECONDS 3600
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+typedef struct {
+	char magic[4];
+	uint32_t version;
+	uint64_t key;
+	uint32_t numResults;
+	uint32_t gridSize;
+} CacheHeader;
+
+// Followed by `length` word bytes, `length` cell indices and `numSwaps` swap cell indices
+typedef struct {
+	uint16_t score;
+	uint8_t length;
+	uint8_t numSwaps;
+} CacheRecord;
+
+typedef struct {
+	char *path;
+	off_t size;
+	time_t mtime;
+} CacheEntry;
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t len) {
+	const unsigned char *bytes = data;
+	for (size_t i = 0; i < len; i++) {
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+static void entryPath(char *buffer, size_t bufferSize, const char *cacheDir, uint64_t key) {
+	snprintf(buffer, bufferSize, "%s/%016llx" CACHE_SUFFIX, cacheDir, (unsigned long long)key);
+}
+
+static uint64_t hashFile(uint64_t hash, const char *filePath) {
+	int fd = open(filePath, O_RDONLY);
+	if (fd == -1) {
+		perror("Error opening dictionary file");
+		exit(1);
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == -1) {
+		perror("Error reading dictionary file");
+		exit(1);
+	}
+
+	if (st.st_size > 0) {
+		void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			perror("Error mapping dictionary file");
+			exit(1);
+		}
+		hash = fnv1a(hash, data, st.st_size);
+		munmap(data, st.st_size);
+	}
+
+	close(fd);
+	return hash;
+}
+
+uint64_t dictionaryFingerprint(const char *filePath, const char *patchPath) {
+	uint64_t hash = hashFile(FNV_OFFSET, filePath);
+	if (patchPath != NULL) {
+		// Separates "dictionary + patch" from a dictionary that merely ends with the patch's bytes
+		hash = fnv1a(hash, "\0patch", 6);
+		hash = hashFile(hash, patchPath);
+	}
+	return hash;
+}
+
+uint64_t computeCacheKey(const Grid *grid, int maxWordLength, int maxSwaps, uint64_t dictFingerprint) {
+	int numCells = grid->size * grid->size;
+	int32_t settings[3] = {grid->size, maxWordLength, maxSwaps};
+
+	uint64_t hash = fnv1a(FNV_OFFSET, settings, sizeof(settings));
+	hash = fnv1a(hash, &dictFingerprint, sizeof(dictFingerprint));
+	hash = fnv1a(hash, grid->letters, numCells * sizeof(char));
+	hash = fnv1a(hash, grid->letterMultiplier, numCells * sizeof(int));
+	hash = fnv1a(hash, grid->wordMultiplier, numCells * sizeof(int));
+	return hash;
+}
+
+static bool decodeRecord(const unsigned char **cursor, const unsigned char *end, WordResult *result, const Grid *grid) {
+	CacheRecord record;
+	if (end - *cursor < (ptrdiff_t)sizeof(record))
+		return false;
+	memcpy(&record, *cursor, sizeof(record));
+	*cursor += sizeof(record);
+
+	size_t payload = record.length + (record.length + record.numSwaps) * sizeof(uint16_t);
+	if ((size_t)(end - *cursor) < payload)
+		return false;
+
+	if (record.length == 0) {
+		*result = (WordResult){0};
+		return true;
+	}
+
+	// A truncated or corrupted entry must not yield positions outside the grid
+	const unsigned char *cells = *cursor + record.length;
+	for (int i = 0; i < record.length + record.numSwaps; i++) {
+		uint16_t cell;
+		memcpy(&cell, cells + i * sizeof(cell), sizeof(cell));
+		if (cell >= grid->size * grid->size)
+			return false;
+	}
+
+	result->word = malloc(record.length + 1);
+	result->positions = malloc(record.length * sizeof(Position));
+	result->swapPositions = malloc(record.numSwaps * sizeof(Position));
+	result->length = record.length;
+	result->numSwaps = record.numSwaps;
+	result->score = record.score;
+
+	memcpy(result->word, *cursor, record.length);
+	result->word[record.length] = '\0';
+	*cursor += record.length;
+
+	for (int i = 0; i < record.length + record.numSwaps; i++) {
+		uint16_t cell;
+		memcpy(&cell, *cursor, sizeof(cell));
+		*cursor += sizeof(cell);
+		Position pos = {cell / grid->size, cell % grid->size};
+		if (i < record.length)
+			result->positions[i] = pos;
+		else
+			result->swapPositions[i - record.length] = pos;
+	}
+	return true;
+}
+
+WordResult* loadCachedResults(const char *cacheDir, uint64_t key, const Grid *grid, int maxSwaps) {
+	char path[4096];
+	entryPath(path, sizeof(path), cacheDir, key);
+
+	int fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return NULL;
+
+	struct stat st;
+	if (fstat(fd, &st) == -1 || st.st_size < (off_t)sizeof(CacheHeader)) {
+		close(fd);
+		return NULL;
+	}
+
+	void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return NULL;
+
+	CacheHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, CACHE_MAGIC, 4) != 0 || header.version != CACHE_VERSION ||
+		header.key != key || header.numResults != (uint32_t)(maxSwaps + 1) ||
+		header.gridSize != (uint32_t)grid->size) {
+		munmap(data, st.st_size);
+		return NULL;
+	}
+
+	WordResult *bestResults = calloc(maxSwaps + 1, sizeof(WordResult));
+	const unsigned char *cursor = (const unsigned char *)data + sizeof(header);
+	const unsigned char *end = (const unsigned char *)data + st.st_size;
+	for (int i = 0; i <= maxSwaps; i++) {
+		if (!decodeRecord(&cursor, end, &bestResults[i], grid)) {
+			freeBestResults(bestResults, maxSwaps);
+			munmap(data, st.st_size);
+			return NULL;
+		}
+	}
+	munmap(data, st.st_size);
+
+	// Refresh the modification time so eviction approximates least-recently-used
+	utimensat(AT_FDCWD, path, NULL, 0);
+	return bestResults;
+}
+
+static int compareEntriesByAge(const void *a, const void *b) {
+	const CacheEntry *ea = a;
+	const CacheEntry *eb = b;
+	return (ea->mtime > eb->mtime) - (ea->mtime < eb->mtime);
+}
+
+static void evictEntries(const char *cacheDir, long long maxBytes) {
+	DIR *dir = opendir(cacheDir);
+	if (!dir)
+		return;
+
+	CacheEntry *entries = NULL;
+	int numEntries = 0;
+	int capacity = 0;
+	long long totalBytes = 0;
+	size_t suffixLength = strlen(CACHE_SUFFIX);
+	time_t now = time(NULL);
+
+	struct dirent *dirent;
+	while ((dirent = readdir(dir)) != NULL) {
+		size_t nameLength = strlen(dirent->d_name);
+		bool temporary = strncmp(dirent->d_name, TEMP_PREFIX, strlen(TEMP_PREFIX)) == 0;
+		if (!temporary &&
+			(nameLength <= suffixLength || strcmp(dirent->d_name + nameLength - suffixLength, CACHE_SUFFIX) != 0))
+			continue;
+
+		char path[4096];
+		snprintf(path, sizeof(path), "%s/%s", cacheDir, dirent->d_name);
+		struct stat st;
+		if (stat(path, &st) == -1)
+			continue;
+
+		// Another process may still be writing a recent temporary entry
+		if (temporary) {
+			if (now - st.st_mtime > STALE_TEMP_SECONDS)
+				unlink(path);
+			continue;
+		}
+
+		if (numEntries == capacity) {
+			capacity = capacity ? capacity * 2 : 64;
+			entries = realloc(entries, capacity * sizeof(CacheEntry));
+			if (!entries) {
+				fprintf(stderr, "Memory reallocation failed\n");
+				exit(1);
+			}
+		}
+		entries[numEntries++] = (CacheEntry){strdup(path), st.st_size, st.st_mtime};
+		totalBytes += st.st_size;
+	}
+	closedir(dir);
+
+	qsort(entries, numEntries, sizeof(CacheEntry), compareEntriesByAge);
+	for (int i = 0; i < numEntries && totalBytes > maxBytes; i++) {
+		// Another process may have evicted the same entry first, which is fine
+		if (unlink(entries[i].path) == 0)
+			totalBytes -= entries[i].size;
+	}
+
+	for (int i = 0; i < numEntries; i++) {
+		free(entries[i].path);
+	}
+	free(entries);
+}
+
+void storeCachedResults(const char *cacheDir, uint64_t key, const WordResult *bestResults,
+						const Grid *grid, int maxSwaps, long long maxBytes) {
+	if (mkdir(cacheDir, 0755) == -1 && access(cacheDir, W_OK) == -1) {
+		perror("Error creating cache directory");
+		return;
+	}
+
+	char tempPath[4096];
+	snprintf(tempPath, sizeof(tempPath), "%s/" TEMP_PREFIX "XXXXXX", cacheDir);
+	int fd = mkstemp(tempPath);
+	if (fd == -1) {
+		perror("Error creating cache entry");
+		return;
+	}
+
+	FILE *file = fdopen(fd, "wb");
+	CacheHeader header = {
+		.magic = CACHE_MAGIC,
+		.version = CACHE_VERSION,
+		.key = key,
+		.numResults = maxSwaps + 1,
+		.gridSize = grid->size
+	};
+	fwrite(&header, sizeof(header), 1, file);
+
+	for (int i = 0; i <= maxSwaps; i++) {
+		const WordResult *result = &bestResults[i];
+		CacheRecord record = {0};
+		if (result->word != NULL) {
+			record.score = result->score;
+			record.length = result->length;
+			record.numSwaps = result->numSwaps;
+		}
+		fwrite(&record, sizeof(record), 1, file);
+		if (record.length == 0)
+			continue;
+
+		fwrite(result->word, 1, record.length, file);
+		for (int j = 0; j < record.length + record.numSwaps; j++) {
+			const Position *pos = j < record.length ? &result->positions[j] : &result->swapPositions[j - record.length];
+			uint16_t cell = pos->row * grid->size + pos->col;
+			fwrite(&cell, sizeof(cell), 1, file);
+		}
+	}
+
+	if (fclose(file) != 0) {
+		perror("Error writing cache entry");
+		unlink(tempPath);
+		return;
+	}
+
+	// Readers only ever see complete entries, and concurrent writers of the same key simply replace each other
+	char path[4096];
+	entryPath(path, sizeof(path), cacheDir, key);
+	if (rename(tempPath, path) == -1) {
+		perror("Error publishing cache entry");
+		unlink(tempPath);
+		return;
+	}
+
+	if (maxBytes > 0)
+		evictEntries(cacheDir, maxBytes);
+}
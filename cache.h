@@ -0,0 +1,61 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdint.h>
+#include "grid.h"
+#include "word_finder.h"
+
+#define DEFAULT_CACHE_SIZE_MB 64
+
+/**
+ * Computes a fingerprint of a dictionary file and its optional patch from their contents.
+ *
+ * @param filePath The path to the dictionary file.
+ * @param patchPath The path to the dictionary patch file, or NULL.
+ * @return A 64-bit hash of the dictionary contents.
+ */
+uint64_t dictionaryFingerprint(const char *filePath, const char *patchPath);
+
+/**
+ * Computes the cache key for a solve from the normalized grid and search settings.
+ *
+ * @param grid The game grid (letters and multipliers).
+ * @param maxWordLength The maximum allowed word length.
+ * @param maxSwaps The maximum amount of swaps.
+ * @param dictFingerprint The fingerprint of the dictionary in use.
+ * @return A 64-bit key identifying the solve.
+ */
+uint64_t computeCacheKey(const Grid *grid, int maxWordLength, int maxSwaps, uint64_t dictFingerprint);
+
+/**
+ * Looks up a cached set of best results.
+ *
+ * The entry is mapped with mmap and decoded into freshly allocated WordResults.
+ *
+ * @param cacheDir The cache directory.
+ * @param key The cache key from computeCacheKey().
+ * @param grid The game grid the results belong to.
+ * @param maxSwaps The maximum amount of swaps.
+ * @return An array of maxSwaps + 1 best results, or NULL on a miss.
+ */
+WordResult* loadCachedResults(const char *cacheDir, uint64_t key, const Grid *grid, int maxSwaps);
+
+/**
+ * Stores a set of best results in the cache.
+ *
+ * The entry is written to a temporary file and atomically renamed into place,
+ * after which the oldest entries are evicted until the cache fits in maxBytes.
+ * Temporary files that a crashed writer left behind over an hour ago are removed then.
+ * Failures are reported but never fatal, since the cache is only an accelerator.
+ *
+ * @param cacheDir The cache directory.
+ * @param key The cache key from computeCacheKey().
+ * @param bestResults Array of the best WordResults for each number of swaps.
+ * @param grid The game grid the results belong to.
+ * @param maxSwaps The maximum amount of swaps.
+ * @param maxBytes The maximum total size of the cache directory (0 for unbounded).
+ */
+void storeCachedResults(const char *cacheDir, uint64_t key, const WordResult *bestResults,
+						const Grid *grid, int maxSwaps, long long maxBytes);
+
+#endif // CACHE_H
@@ -0,0 +1,295 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "frontier.h"
+
+// Partial paths expanded together; each one fans out to at most 8 neighbors x 26 letters
+#define FRONTIER_BATCH 32
+#define FRONTIER_FANOUT (8 * 26)
+
+typedef uint32_t LetterLanes __attribute__((vector_size(32)));
+typedef uint64_t CellLanes __attribute__((vector_size(64)));
+
+// Per-board lookup tables, one vector lane per neighbor direction
+typedef struct {
+	LetterLanes neighborLetters[FRONTIER_MAX_CELLS]; // 1 << letter of each neighbor, 0 past the edge
+	CellLanes neighborCells[FRONTIER_MAX_CELLS];     // 1 << cell of each neighbor, 0 past the edge
+	uint8_t neighborIndex[FRONTIER_MAX_CELLS][8];
+	unsigned char letterScore[FRONTIER_MAX_CELLS][26];
+	uint16_t wordMultiplier[FRONTIER_MAX_CELLS];
+	uint32_t boardLetters;                           // 1 << letter of every cell
+} BoardTables;
+
+// One depth level of partial paths, stored as structure-of-arrays
+typedef struct {
+	int count;
+	uint8_t *cell;
+	uint8_t *letter;
+	uint8_t *swapsLeft;
+	uint8_t *swapped;
+	uint16_t *baseScore;
+	uint16_t *wordMultiplier;
+	int32_t *parent;        // Index of the path's prefix in the previous level
+	uint64_t *visited;
+	TrieNode **node;        // Trie node reached after this cell's letter
+} FrontierLevel;
+
+typedef struct {
+	const Grid *grid;
+	const BoardTables *tables;
+	int maxWordLength;
+	int maxSwaps;
+	FrontierLevel *levels;
+	SearchScratch *scratch;
+} FrontierState;
+
+typedef struct {
+	uint8_t cell;
+	uint8_t letter;
+} FrontierRoot;
+
+static void buildBoardTables(const Grid *grid, BoardTables *tables) {
+	const int directions[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1},
+								  {0, 1},   {1, -1}, {1, 0},  {1, 1}};
+	int numCells = grid->size * grid->size;
+	tables->boardLetters = 0;
+
+	for (int cell = 0; cell < numCells; cell++) {
+		int row = cell / grid->size;
+		int col = cell % grid->size;
+		for (int lane = 0; lane < 8; lane++) {
+			int newRow = row + directions[lane][0];
+			int newCol = col + directions[lane][1];
+			bool inside = newRow >= 0 && newRow < grid->size && newCol >= 0 && newCol < grid->size;
+			int neighbor = inside ? newRow * grid->size + newCol : 0;
+			tables->neighborLetters[cell][lane] = inside ? 1U << (grid->letters[neighbor] - 'A') : 0;
+			tables->neighborCells[cell][lane] = inside ? 1ULL << neighbor : 0;
+			tables->neighborIndex[cell][lane] = neighbor;
+		}
+		for (int letter = 0; letter < 26; letter++) {
+			tables->letterScore[cell][letter] = SCORES[letter] * grid->letterMultiplier[cell];
+		}
+		tables->wordMultiplier[cell] = grid->wordMultiplier[cell];
+		tables->boardLetters |= 1U << (grid->letters[cell] - 'A');
+	}
+}
+
+static void allocateLevel(FrontierLevel *level, int capacity) {
+	level->count = 0;
+	level->cell = malloc(capacity * sizeof(uint8_t));
+	level->letter = malloc(capacity * sizeof(uint8_t));
+	level->swapsLeft = malloc(capacity * sizeof(uint8_t));
+	level->swapped = malloc(capacity * sizeof(uint8_t));
+	level->baseScore = malloc(capacity * sizeof(uint16_t));
+	level->wordMultiplier = malloc(capacity * sizeof(uint16_t));
+	level->parent = malloc(capacity * sizeof(int32_t));
+	level->visited = malloc(capacity * sizeof(uint64_t));
+	level->node = malloc(capacity * sizeof(TrieNode *));
+	if (!level->cell || !level->letter || !level->swapsLeft || !level->swapped || !level->baseScore ||
+		!level->wordMultiplier || !level->parent || !level->visited || !level->node) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+}
+
+static void freeLevel(FrontierLevel *level) {
+	free(level->cell);
+	free(level->letter);
+	free(level->swapsLeft);
+	free(level->swapped);
+	free(level->baseScore);
+	free(level->wordMultiplier);
+	free(level->parent);
+	free(level->visited);
+	free(level->node);
+}
+
+static inline void pushPath(FrontierLevel *next, const FrontierLevel *level, int parent, int cell, int letter,
+							TrieNode *node, int swapped, const BoardTables *tables) {
+	int j = next->count++;
+	next->cell[j] = cell;
+	next->letter[j] = letter;
+	next->swapsLeft[j] = level->swapsLeft[parent] - swapped;
+	next->swapped[j] = swapped;
+	next->baseScore[j] = level->baseScore[parent] + tables->letterScore[cell][letter];
+	next->wordMultiplier[j] = level->wordMultiplier[parent] * tables->wordMultiplier[cell];
+	next->parent[j] = parent;
+	next->visited[j] = level->visited[parent] | (1ULL << cell);
+	next->node[j] = node;
+}
+
+// Appends every one-cell extension of paths [start, end) of a level to the next level
+static void expandBatch(FrontierState *state, int depth, int start, int end) {
+	const BoardTables *tables = state->tables;
+	const FrontierLevel *level = &state->levels[depth];
+	FrontierLevel *next = &state->levels[depth + 1];
+	next->count = 0;
+
+	for (int i = start; i < end; i++) {
+		TrieNode *node = level->node[i];
+		uint32_t children = node->children;
+		// Nothing below fits the length limit (the node itself was already reported if it is a word)
+		if (!children || node->minWordLength > state->maxWordLength)
+			continue;
+
+		// All 8 neighbors at once: does the neighbor's own letter continue a word, and is it free?
+		int cell = level->cell[i];
+		LetterLanes matches = tables->neighborLetters[cell] & children;
+		CellLanes open = tables->neighborCells[cell] & ~level->visited[i];
+		unsigned int openMask = 0;
+		for (int lane = 0; lane < 8; lane++) {
+			openMask |= (open[lane] != 0) << lane;
+		}
+
+		bool canSwap = level->swapsLeft[i] > 0;
+		while (openMask) {
+			int lane = __builtin_ctz(openMask);
+			openMask &= (openMask - 1);
+			int neighbor = tables->neighborIndex[cell][lane];
+
+			if (matches[lane]) {
+				int letter = __builtin_ctz(matches[lane]);
+				pushPath(next, level, i, neighbor, letter, node->childPtrs[letter], 0, tables);
+			}
+			if (canSwap) {
+				uint32_t others = children & ~tables->neighborLetters[cell][lane];
+				while (others) {
+					int letter = __builtin_ctz(others);
+					others &= (others - 1);
+					// The swap must leave enough swaps for the letters below the child that the board lacks
+					TrieNode *child = node->childPtrs[letter];
+					if (__builtin_popcount(child->requiredLetters & ~tables->boardLetters) < level->swapsLeft[i])
+						pushPath(next, level, i, neighbor, letter, child, 1, tables);
+				}
+			}
+		}
+	}
+}
+
+static void reportWord(FrontierState *state, int depth, int index) {
+	const FrontierLevel *level = &state->levels[depth];
+	int length = depth + 1;
+	int swaps = state->maxSwaps - level->swapsLeft[index];
+	unsigned short score = level->baseScore[index] * level->wordMultiplier[index] + (length > 6) * 10;
+
+	WordResult *best = &state->scratch->best[swaps];
+	if (score <= best->score)
+		return;
+
+	// Rebuild the path by following the parent links back to the start cell
+	int swapIndex = swaps;
+	for (int d = depth, k = index; d >= 0; k = state->levels[d].parent[k], d--) {
+		int cell = state->levels[d].cell[k];
+		Position position = {cell / state->grid->size, cell % state->grid->size};
+		best->word[d] = 'A' + state->levels[d].letter[k];
+		best->positions[d] = position;
+		if (state->levels[d].swapped[k])
+			best->swapPositions[--swapIndex] = position;
+	}
+	best->word[length] = '\0';
+	best->length = length;
+	best->numSwaps = swaps;
+	best->score = score;
+}
+
+static void processLevel(FrontierState *state, int depth) {
+	const FrontierLevel *level = &state->levels[depth];
+	FrontierLevel *next = &state->levels[depth + 1];
+
+	for (int start = 0; start < level->count; start += FRONTIER_BATCH) {
+		int end = start + FRONTIER_BATCH < level->count ? start + FRONTIER_BATCH : level->count;
+		expandBatch(state, depth, start, end);
+
+		// Issue the loads of the whole batch's trie nodes before any of them is needed
+		for (int j = 0; j < next->count; j++) {
+			__builtin_prefetch(next->node[j]);
+		}
+		for (int j = 0; j < next->count; j++) {
+			if (next->node[j]->isWord)
+				reportWord(state, depth + 1, j);
+			__builtin_prefetch(next->node[j]->childPtrs);
+		}
+
+		if (depth + 2 < state->maxWordLength)
+			processLevel(state, depth + 1);
+	}
+}
+
+WordResult* findBestResultsFrontier(const Grid *grid, TrieNode *trie, int maxWordLength, int maxSwaps) {
+	int numCells = grid->size * grid->size;
+	if (numCells > FRONTIER_MAX_CELLS)
+		return findBestResults(grid, trie, maxWordLength, maxSwaps);
+
+	WordResult *bestResults = calloc(maxSwaps + 1, sizeof(WordResult));
+	BoardTables *tables = malloc(sizeof(BoardTables));
+	FrontierRoot *roots = malloc(numCells * 26 * sizeof(FrontierRoot));
+	if (!bestResults || !tables || !roots) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	buildBoardTables(grid, tables);
+
+	int numRoots = 0;
+	for (int cell = 0; cell < numCells && maxWordLength > 1; cell++) {
+		int gridLetter = grid->letters[cell] - 'A';
+		uint32_t letters = maxSwaps > 0 ? trie->children : trie->children & (1U << gridLetter);
+		while (letters) {
+			int letter = __builtin_ctz(letters);
+			letters &= (letters - 1);
+			roots[numRoots++] = (FrontierRoot){cell, letter};
+		}
+	}
+	int numChunks = (numRoots + FRONTIER_BATCH - 1) / FRONTIER_BATCH;
+
+	#pragma omp parallel
+	{
+		FrontierState state = {
+			.grid = grid,
+			.tables = tables,
+			.maxWordLength = maxWordLength,
+			.maxSwaps = maxSwaps,
+			.levels = malloc(maxWordLength * sizeof(FrontierLevel)),
+			.scratch = createSearchScratch(grid->size, maxWordLength, maxSwaps)
+		};
+		allocateLevel(&state.levels[0], FRONTIER_BATCH);
+		for (int d = 1; d < maxWordLength; d++) {
+			allocateLevel(&state.levels[d], FRONTIER_BATCH * FRONTIER_FANOUT);
+		}
+
+		#pragma omp for schedule(dynamic, 1)
+		for (int chunk = 0; chunk < numChunks; chunk++) {
+			FrontierLevel *level = &state.levels[0];
+			level->count = 0;
+			for (int r = chunk * FRONTIER_BATCH; r < numRoots && r < (chunk + 1) * FRONTIER_BATCH; r++) {
+				int cell = roots[r].cell;
+				int letter = roots[r].letter;
+				int swapped = (letter != grid->letters[cell] - 'A');
+				int j = level->count++;
+				level->cell[j] = cell;
+				level->letter[j] = letter;
+				level->swapsLeft[j] = maxSwaps - swapped;
+				level->swapped[j] = swapped;
+				level->baseScore[j] = tables->letterScore[cell][letter];
+				level->wordMultiplier[j] = tables->wordMultiplier[cell];
+				level->parent[j] = -1;
+				level->visited[j] = 1ULL << cell;
+				level->node[j] = trie->childPtrs[letter];
+			}
+			processLevel(&state, 0);
+		}
+
+		#pragma omp critical
+		mergeBestWords(bestResults, state.scratch->best, maxSwaps);
+
+		for (int d = 0; d < maxWordLength; d++) {
+			freeLevel(&state.levels[d]);
+		}
+		free(state.levels);
+		freeSearchScratch(state.scratch);
+	}
+
+	free(roots);
+	free(tables);
+	return bestResults;
+}
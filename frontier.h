@@ -0,0 +1,28 @@
+#ifndef FRONTIER_H
+#define FRONTIER_H
+
+#include "grid.h"
+#include "trie.h"
+#include "word_finder.h"
+
+// Visited cells are tracked in a single 64-bit mask per partial path
+#define FRONTIER_MAX_CELLS 64
+
+/**
+ * Finds the highest scoring word for each number of swaps with the batched frontier engine.
+ *
+ * Instead of following one path at a time, partial paths are advanced a batch at a
+ * time, one depth level after another, as structure-of-arrays batches. Child masks of
+ * a whole batch are expanded with vector operations and the next level's trie nodes
+ * are prefetched together, so trie loads overlap instead of forming a serial chain.
+ * Boards with more than FRONTIER_MAX_CELLS cells fall back to findBestResults().
+ *
+ * @param grid The game grid.
+ * @param trie The Trie containing the dictionary.
+ * @param maxWordLength The maximum allowed word length.
+ * @param maxSwaps The maximum amount of swaps.
+ * @return An array of maxSwaps + 1 WordResults, with a NULL word where nothing was found.
+ */
+WordResult* findBestResultsFrontier(const Grid *grid, TrieNode *trie, int maxWordLength, int maxSwaps);
+
+#endif // FRONTIER_H
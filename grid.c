@@ -6,6 +6,9 @@
 
 #define MAX_LINE_LENGTH 1024
 
+static const unsigned char LETTER_WEIGHTS[26] = {9, 2, 2, 4, 12, 2, 3, 2, 9, 1, 1, 4, 2, 6, 8, 2, 1, 6, 4, 6, 4, 2, 2, 1, 2, 1};
+#define LETTER_WEIGHT_TOTAL 98
+
 Grid* createGrid(int size) {
 	Grid *grid = malloc(sizeof(Grid));
 	grid->size = size;
@@ -61,6 +64,35 @@ void loadGrid(const char *filePath, Grid *grid) {
 	fclose(file);
 }
 
+void copyGrid(Grid *dest, const Grid *src) {
+	int numCells = src->size * src->size;
+	memcpy(dest->letters, src->letters, numCells * sizeof(char));
+	memcpy(dest->letterMultiplier, src->letterMultiplier, numCells * sizeof(int));
+	memcpy(dest->wordMultiplier, src->wordMultiplier, numCells * sizeof(int));
+}
+
+// splitmix64
+static uint64_t nextRandom(uint64_t *rngState) {
+	uint64_t z = (*rngState += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+char randomGridLetter(uint64_t *rngState) {
+	int pick = nextRandom(rngState) % LETTER_WEIGHT_TOTAL;
+	int letter = 0;
+	while (pick >= LETTER_WEIGHTS[letter]) {
+		pick -= LETTER_WEIGHTS[letter];
+		letter++;
+	}
+	return 'A' + letter;
+}
+
+int randomGridCell(const Grid *grid, uint64_t *rngState) {
+	return nextRandom(rngState) % (uint64_t)(grid->size * grid->size);
+}
+
 void freeGrid(Grid *grid) {
 	free(grid->letters);
 	free(grid->letterMultiplier);
@@ -2,6 +2,7 @@
 #define GRID_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 typedef struct {
 	int row;
@@ -31,6 +32,31 @@ Grid* createGrid(int size);
  */
 void loadGrid(const char *filePath, Grid *grid);
 
+/**
+ * Copies the letters and multipliers of one grid into another of the same size.
+ *
+ * @param dest Pointer to the Grid structure to copy into.
+ * @param src Pointer to the Grid structure to copy from.
+ */
+void copyGrid(Grid *dest, const Grid *src);
+
+/**
+ * Draws a random letter with Scrabble tile frequencies.
+ *
+ * @param rngState The state of the caller's random number generator, advanced by the call.
+ * @return An uppercase letter.
+ */
+char randomGridLetter(uint64_t *rngState);
+
+/**
+ * Draws a cell of the grid uniformly at random.
+ *
+ * @param grid Pointer to the Grid structure.
+ * @param rngState The state of the caller's random number generator, advanced by the call.
+ * @return A cell index (row * size + col).
+ */
+int randomGridCell(const Grid *grid, uint64_t *rngState);
+
 /**
  * Frees the memory allocated for the Grid structure.
  *
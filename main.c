@@ -1,18 +1,359 @@
+#include <ctype.h>
 #include <getopt.h>
+#include <omp.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include "grid.h"
 #include "trie.h"
 #include "word_finder.h"
 #include "output.h"
+#include "cache.h"
+#include "planner.h"
+#include "frontier.h"
+#include "topology.h"
+#include "perf_counters.h"
 
 #define DEFAULT_MAX_WORD_LENGTH 14
 #define DEFAULT_MAX_SWAPS 2
 #define DEFAULT_GRID_SIZE 5
 #define DEFAULT_DICT_FILE "resources/dictionary.txt"
 
+// Removed words pending before a batch run compacts the trie in the background
+#define COMPACTION_THRESHOLD 256
+
+typedef struct {
+	int maxWordLength;
+	int maxSwaps;
+	int gridSize;
+	const char *dictFiles[MAX_WORD_LISTS]; // Merged into one Trie, one word list each
+	int numDicts;
+	char *patchFile;
+	OutputFormat format;
+	bool useFrontier;
+	bool numa;
+	bool showStats;
+	bool showPerf;
+	bool batch;
+	char *cacheDir;
+	long long cacheSizeMb;
+	PlanOptions planOptions;
+	SearchConstraints constraints;
+} Options;
+
+typedef struct {
+	TrieNode *trie;
+	TrieReplicas *replicas;
+	uint64_t fingerprint;
+	AppliedPatch appliedPatch;
+	struct timespec patchMtime;
+	off_t patchSize;
+	int pendingRemovals;
+	bool compacting;
+	pthread_t compactionThread;
+} ResidentDictionary;
+
+// Counters reported per phase with --perf, or NULL
+static PerfCounters *perfCounters = NULL;
+static const char *perfPhase = NULL;
+
+// Reports the running phase, if any, and starts counting the next one (NULL to stop)
+static void enterPhase(const char *phase) {
+	if (perfCounters == NULL)
+		return;
+	if (perfPhase != NULL) {
+		PerfSample sample = endPerfPhase(perfCounters);
+		printPerfSample(stderr, perfPhase, &sample);
+	}
+	perfPhase = phase;
+	if (phase != NULL)
+		beginPerfPhase(perfCounters);
+}
+
+static void closePhases(void) {
+	if (perfCounters == NULL)
+		return;
+	enterPhase(NULL);
+	closePerfCounters(perfCounters);
+	perfCounters = NULL;
+}
+
+static bool isConstrained(const Options *options) {
+	const SearchConstraints *constraints = &options->constraints;
+	return constraints->minLength > 0 || constraints->maxLength > 0 || constraints->requiredLetters != 0 ||
+		   constraints->numMustUse > 0 || constraints->numAvoid > 0;
+}
+
+// Parses a "row,col" argument and appends the cell to a list
+static bool addCell(const char *arg, Position **cells, int *numCells) {
+	int row, col;
+	char extra;
+	if (sscanf(arg, "%d,%d%c", &row, &col, &extra) != 2)
+		return false;
+	Position *temp = realloc(*cells, (*numCells + 1) * sizeof(Position));
+	if (!temp) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	*cells = temp;
+	(*cells)[(*numCells)++] = (Position){row, col};
+	return true;
+}
+
+static bool addRequiredLetters(const char *arg, uint32_t *letters) {
+	if (*arg == '\0')
+		return false;
+	for (; *arg; arg++) {
+		if (!isalpha((unsigned char)*arg))
+			return false;
+		*letters |= 1U << (toupper((unsigned char)*arg) - 'A');
+	}
+	return true;
+}
+
+// Parses a comma-separated list of dictionary files
+static bool setDictionaries(char *arg, Options *options) {
+	options->numDicts = 0;
+	for (char *file = strtok(arg, ","); file != NULL; file = strtok(NULL, ",")) {
+		if (options->numDicts == MAX_WORD_LISTS)
+			return false;
+		options->dictFiles[options->numDicts++] = file;
+	}
+	return options->numDicts > 0;
+}
+
+static void freeConstraints(Options *options) {
+	free(options->constraints.mustUse);
+	free(options->constraints.avoid);
+}
+
+static bool validateConstraints(const Options *options) {
+	const SearchConstraints *constraints = &options->constraints;
+	if (options->maxWordLength < 1 || options->maxWordLength > DICTIONARY_MAX_WORD_LENGTH) {
+		fprintf(stderr, "--maxwordlength must be between 1 and %d\n", DICTIONARY_MAX_WORD_LENGTH);
+		return false;
+	}
+	if (options->maxSwaps < 0 || options->maxSwaps > MAX_SWAPS) {
+		fprintf(stderr, "--maxswaps must be between 0 and %d\n", MAX_SWAPS);
+		return false;
+	}
+	for (int i = 0; i < constraints->numMustUse + constraints->numAvoid; i++) {
+		Position cell = i < constraints->numMustUse ? constraints->mustUse[i]
+													: constraints->avoid[i - constraints->numMustUse];
+		if (cell.row < 0 || cell.row >= options->gridSize || cell.col < 0 || cell.col >= options->gridSize) {
+			fprintf(stderr, "Cell %d,%d is outside the grid\n", cell.row, cell.col);
+			return false;
+		}
+	}
+	if (isConstrained(options) && (options->planOptions.turns > 1 || options->useFrontier)) {
+		fprintf(stderr, "Search constraints cannot be combined with --plan or --engine frontier\n");
+		return false;
+	}
+	if (options->numDicts > 1 && (options->planOptions.turns > 1 || options->useFrontier || options->numa ||
+								  options->cacheDir != NULL)) {
+		fprintf(stderr, "Several dictionaries cannot be combined with --plan, --engine frontier, --numa or --cache\n");
+		return false;
+	}
+	if (options->format == OUTPUT_BINARY && options->planOptions.turns > 1) {
+		fprintf(stderr, "The binary format cannot be combined with --plan\n");
+		return false;
+	}
+	return true;
+}
+
+static void printStats(const Options *options) {
+	if (!options->showStats)
+		return;
+	SearchStats stats = takeSearchStats();
+	fprintf(stderr, "Reachability memo: %llu lookups, %.1f%% hits, %llu branches pruned\n", stats.memoLookups,
+			stats.memoLookups ? 100.0 * stats.memoHits / stats.memoLookups : 0.0, stats.memoPrunes);
+	fprintf(stderr, "Required letters: %llu branches pruned\n", stats.letterPrunes);
+	fprintf(stderr, "Parallelism: %llu serial, %llu small team, %llu full machine (up to %d threads), estimated cost %llu\n",
+			stats.serialSearches, stats.smallTeamSearches, stats.fullSearches, omp_get_max_threads(),
+			stats.estimatedCost);
+}
+
+static uint64_t solveFingerprint(const Options *options) {
+	return dictionaryFingerprint(options->dictFiles[0], options->patchFile);
+}
+
+static void applyPatch(TrieNode *trie, const Options *options, AppliedPatch *applied, int *removed) {
+	int added = 0;
+	*removed = 0;
+	if (applyDictionaryPatch(trie, options->patchFile, DICTIONARY_MAX_WORD_LENGTH, &added, removed, applied)) {
+		fprintf(stderr, "Applied dictionary patch %s: %d added, %d removed\n", options->patchFile, added, *removed);
+	}
+}
+
+static void* compactionThread(void *arg) {
+	compactTrie(arg);
+	return NULL;
+}
+
+static void finishCompaction(ResidentDictionary *dict) {
+	if (dict->compacting) {
+		pthread_join(dict->compactionThread, NULL);
+		dict->compacting = false;
+	}
+}
+
+// Replaces the applied patch whenever the patch file changes; only ever called between solves
+static void refreshPatch(ResidentDictionary *dict, const Options *options) {
+	struct stat st;
+	if (options->patchFile == NULL || stat(options->patchFile, &st) == -1)
+		return;
+	if (st.st_mtim.tv_sec == dict->patchMtime.tv_sec && st.st_mtim.tv_nsec == dict->patchMtime.tv_nsec &&
+		st.st_size == dict->patchSize)
+		return;
+
+	dict->patchMtime = st.st_mtim;
+	dict->patchSize = st.st_size;
+	finishCompaction(dict);
+	dict->pendingRemovals += revertDictionaryPatch(dict->trie, &dict->appliedPatch);
+	int removed;
+	applyPatch(dict->trie, options, &dict->appliedPatch, &removed);
+	dict->pendingRemovals += removed;
+	if (dict->replicas != NULL && dict->replicas->replicated) {
+		freeTrieReplicas(dict->replicas);
+		dict->replicas = createTrieReplicas(dict->trie, true);
+	}
+	if (options->cacheDir != NULL)
+		dict->fingerprint = solveFingerprint(options);
+}
+
+// Tombstones are reclaimed while the batch waits for its next grid
+static void scheduleCompaction(ResidentDictionary *dict) {
+	if (dict->compacting || dict->pendingRemovals < COMPACTION_THRESHOLD)
+		return;
+	if (pthread_create(&dict->compactionThread, NULL, compactionThread, dict->trie) == 0) {
+		dict->compacting = true;
+		dict->pendingRemovals = 0;
+	}
+}
+
+// Prints the cached results for the grid if there are any; cacheKey is set either way
+static bool serveFromCache(const Options *options, const Grid *grid, uint64_t fingerprint, uint64_t *cacheKey) {
+	enterPhase("cache");
+	*cacheKey = computeCacheKey(grid, options->maxWordLength, options->maxSwaps, fingerprint);
+	WordResult *cachedResults = loadCachedResults(options->cacheDir, *cacheKey, grid, options->maxSwaps);
+	if (cachedResults == NULL)
+		return false;
+
+	enterPhase("output");
+	outputResults(cachedResults, options->maxSwaps, grid, options->format);
+	fflush(stdout);
+	freeBestResults(cachedResults, options->maxSwaps);
+	return true;
+}
+
+static void finishSolve(const Options *options, const Grid *grid, WordResult *bestResults, uint64_t cacheKey) {
+	enterPhase("output");
+	if (options->cacheDir != NULL && !isConstrained(options)) {
+		storeCachedResults(options->cacheDir, cacheKey, bestResults, grid, options->maxSwaps,
+						   options->cacheSizeMb * 1024 * 1024);
+	}
+
+	outputResults(bestResults, options->maxSwaps, grid, options->format);
+	fflush(stdout);
+	freeBestResults(bestResults, options->maxSwaps);
+}
+
+static void solveWithTrie(const Options *options, const Grid *grid, TrieNode *trie, const TrieReplicas *replicas,
+						  uint64_t cacheKey) {
+	enterPhase("search");
+	if (options->planOptions.turns > 1) {
+		int numCandidates = 0;
+		PlanCandidate *candidates = planTurns(grid, trie, options->maxWordLength, options->maxSwaps,
+											  &options->planOptions, &numCandidates);
+		enterPhase("output");
+		outputPlan(candidates, numCandidates, grid, options->format == OUTPUT_JSON);
+		fflush(stdout);
+		freePlanCandidates(candidates, numCandidates);
+		return;
+	}
+
+	const SearchConstraints *constraints = isConstrained(options) ? &options->constraints : NULL;
+	if (options->numDicts > 1) {
+		int lastResult = options->numDicts * (options->maxSwaps + 1) - 1;
+		WordResult *results = findBestResultsPerList(grid, trie, options->maxWordLength, options->maxSwaps,
+													 options->numDicts, constraints);
+		enterPhase("output");
+		outputListResults(results, options->numDicts, options->dictFiles, options->maxSwaps, grid,
+						  options->format);
+		fflush(stdout);
+		freeBestResults(results, lastResult);
+		return;
+	}
+
+	WordResult *bestResults;
+	if (constraints != NULL)
+		bestResults = findBestResultsConstrained(grid, trie, options->maxWordLength, options->maxSwaps, constraints);
+	else if (options->useFrontier)
+		bestResults = findBestResultsFrontier(grid, trie, options->maxWordLength, options->maxSwaps);
+	else if (replicas != NULL)
+		bestResults = findBestResultsReplicated(grid, replicas, options->maxWordLength, options->maxSwaps);
+	else
+		bestResults = findBestResults(grid, trie, options->maxWordLength, options->maxSwaps);
+	finishSolve(options, grid, bestResults, cacheKey);
+}
+
+// Solves every grid file listed in listFile (or stdin for "-") with one resident dictionary
+static int runBatch(const Options *options, const char *listFile) {
+	FILE *list = strcmp(listFile, "-") == 0 ? stdin : fopen(listFile, "r");
+	if (!list) {
+		perror("Error opening batch file");
+		return 1;
+	}
+
+	enterPhase("dictionary");
+	ResidentDictionary dict = {0};
+	dict.trie = loadDictionaries(options->dictFiles, options->numDicts, DICTIONARY_MAX_WORD_LENGTH);
+	if (options->cacheDir != NULL)
+		dict.fingerprint = solveFingerprint(options);
+	refreshPatch(&dict, options);
+	if (options->numa) {
+		dict.replicas = createTrieReplicas(dict.trie, true);
+		pinSearchThreads(dict.replicas);
+	}
+	Grid *grid = createGrid(options->gridSize);
+
+	char *line = NULL;
+	size_t len = 0;
+	while (getline(&line, &len, list) != -1) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if (line[0] == '\0')
+			continue;
+
+		enterPhase("dictionary");
+		refreshPatch(&dict, options);
+		finishCompaction(&dict);
+		enterPhase("grid");
+		loadGrid(line, grid);
+		uint64_t cacheKey = 0;
+		if (options->cacheDir != NULL && options->planOptions.turns <= 1 && !isConstrained(options) &&
+			serveFromCache(options, grid, dict.fingerprint, &cacheKey))
+			continue;
+		solveWithTrie(options, grid, dict.trie, dict.replicas, cacheKey);
+		scheduleCompaction(&dict);
+	}
+
+	enterPhase("cleanup");
+	finishCompaction(&dict);
+	free(line);
+	if (list != stdin)
+		fclose(list);
+	freeGrid(grid);
+	if (dict.replicas != NULL)
+		freeTrieReplicas(dict.replicas);
+	revertDictionaryPatch(dict.trie, &dict.appliedPatch);
+	freeTrie(dict.trie);
+	return 0;
+}
+
+
 int main(int argc, char *argv[]) {
 	if (argc < 2) {
 		fprintf(stderr, "Usage: %s <grid_file> [options]\n", argv[0]);
@@ -20,17 +361,53 @@ int main(int argc, char *argv[]) {
 		fprintf(stderr, "  --maxwordlength <value>  Maximum word length (default: 14)\n");
 		fprintf(stderr, "  --maxswaps <value>       Maximum number of swaps (default: 2)\n");
 		fprintf(stderr, "  --gridsize <value>       Grid size (default: 5)\n");
-		fprintf(stderr, "  --dict <file>            Dictionary file path (default: resources/dictionary.txt)\n");
-		fprintf(stderr, "  --json <true/false>      Output in JSON format (default: false)\n");
+		fprintf(stderr, "  --dict <file[,file...]>  Dictionary file path; several are searched together (default: resources/dictionary.txt)\n");
+		fprintf(stderr, "  --patch <file>           Dictionary patch file of +word/-word lines (default: none)\n");
+		fprintf(stderr, "  --format <text/json/bin> Output format; bin is read with binary_results.h (default: text)\n");
+		fprintf(stderr, "  --json <true/false>      Same as --format json (default: false)\n");
+		fprintf(stderr, "  --engine <dfs/frontier>  Search engine (default: dfs)\n");
+		fprintf(stderr, "  --numa <true/false>      Replicate the dictionary on each NUMA node and pin threads (default: false)\n");
+		fprintf(stderr, "  --memo <true/false>      Prune branches that cannot reach any word (default: true)\n");
+		fprintf(stderr, "  --stats <true/false>     Print search statistics to stderr (default: false)\n");
+		fprintf(stderr, "  --perf <true/false>      Print per-phase hardware counters to stderr as JSON lines (default: false)\n");
+		fprintf(stderr, "  --must-use <row,col>     Only find words through this cell (repeatable)\n");
+		fprintf(stderr, "  --avoid <row,col>        Only find words that do not use this cell (repeatable)\n");
+		fprintf(stderr, "  --min-length <value>     Minimum word length (default: none)\n");
+		fprintf(stderr, "  --max-length <value>     Maximum word length, without reloading the dictionary (default: none)\n");
+		fprintf(stderr, "  --require-letter <letters> Only find words containing all of these letters\n");
+		fprintf(stderr, "  --batch <true/false>     Treat <grid_file> as a list of grid files, or - for stdin (default: false)\n");
+		fprintf(stderr, "  --cache <dir>            Cache solved results in a directory (default: disabled)\n");
+		fprintf(stderr, "  --cachesize <MiB>        Maximum cache directory size (default: 64)\n");
+		fprintf(stderr, "  --plan <turns>           Rank words by expected score over several turns (default: disabled)\n");
+		fprintf(stderr, "  --candidates <value>     Words evaluated by the planner (default: 8)\n");
+		fprintf(stderr, "  --rollouts <value>       Random continuations per planner candidate (default: 200)\n");
+		fprintf(stderr, "  --seed <value>           Planner random seed (default: 1)\n");
 		return 1;
 	}
 
 	char *gridFile = argv[1];
-	int maxWordLength = DEFAULT_MAX_WORD_LENGTH;
-	int maxSwaps = DEFAULT_MAX_SWAPS;
-	int gridSize = DEFAULT_GRID_SIZE;
-	char *dictFile = DEFAULT_DICT_FILE;
-	bool useJson = false;
+	Options options = {
+		.maxWordLength = DEFAULT_MAX_WORD_LENGTH,
+		.maxSwaps = DEFAULT_MAX_SWAPS,
+		.gridSize = DEFAULT_GRID_SIZE,
+		.dictFiles = {DEFAULT_DICT_FILE},
+		.numDicts = 1,
+		.patchFile = NULL,
+		.format = OUTPUT_TEXT,
+		.useFrontier = false,
+		.numa = false,
+		.showStats = false,
+		.showPerf = false,
+		.batch = false,
+		.cacheDir = NULL,
+		.cacheSizeMb = DEFAULT_CACHE_SIZE_MB,
+		.planOptions = {
+			.turns = 1,
+			.numCandidates = DEFAULT_PLAN_CANDIDATES,
+			.rollouts = DEFAULT_PLAN_ROLLOUTS,
+			.seed = 1
+		}
+	};
 
 	int opt;
 	static struct option longOptions[] = {
@@ -38,66 +415,171 @@ int main(int argc, char *argv[]) {
 		{"maxswaps", required_argument, 0, 's'},
 		{"gridsize", required_argument, 0, 'g'},
 		{"dict", required_argument, 0, 'd'},
+		{"patch", required_argument, 0, 'P'},
+		{"format", required_argument, 0, 'F'},
 		{"json", required_argument, 0, 'j'},
+		{"engine", required_argument, 0, 'e'},
+		{"numa", required_argument, 0, 'n'},
+		{"memo", required_argument, 0, 'm'},
+		{"stats", required_argument, 0, 't'},
+		{"perf", required_argument, 0, 'f'},
+		{"must-use", required_argument, 0, 'u'},
+		{"avoid", required_argument, 0, 'a'},
+		{"min-length", required_argument, 0, 'l'},
+		{"max-length", required_argument, 0, 'L'},
+		{"require-letter", required_argument, 0, 'R'},
+		{"batch", required_argument, 0, 'b'},
+		{"cache", required_argument, 0, 'c'},
+		{"cachesize", required_argument, 0, 'C'},
+		{"plan", required_argument, 0, 'p'},
+		{"candidates", required_argument, 0, 'k'},
+		{"rollouts", required_argument, 0, 'r'},
+		{"seed", required_argument, 0, 'S'},
 		{0, 0, 0, 0}
 	};
 
-	while ((opt = getopt_long(argc, argv, "w:s:g:d:j:", longOptions, NULL)) != -1) {
+	while ((opt = getopt_long(argc, argv, "w:s:g:d:P:F:j:e:n:m:t:f:u:a:l:L:R:b:c:C:p:k:r:S:", longOptions, NULL)) != -1) {
 		switch (opt) {
-			case 'w': maxWordLength = atoi(optarg); break;
-			case 's': maxSwaps = atoi(optarg); break;
-			case 'g': gridSize = atoi(optarg); break;
-			case 'd': dictFile = optarg; break;
-			case 'j': useJson = (strcmp(optarg, "true") == 0); break;
+			case 'w': options.maxWordLength = atoi(optarg); break;
+			case 's': options.maxSwaps = atoi(optarg); break;
+			case 'g': options.gridSize = atoi(optarg); break;
+			case 'd':
+				if (!setDictionaries(optarg, &options)) {
+					fprintf(stderr, "Expected 1 to %d dictionary files: %s\n", MAX_WORD_LISTS, optarg);
+					return 1;
+				}
+				break;
+			case 'P': options.patchFile = optarg; break;
+			case 'F':
+				if (strcmp(optarg, "text") == 0) {
+					options.format = OUTPUT_TEXT;
+				} else if (strcmp(optarg, "json") == 0) {
+					options.format = OUTPUT_JSON;
+				} else if (strcmp(optarg, "bin") == 0) {
+					options.format = OUTPUT_BINARY;
+				} else {
+					fprintf(stderr, "Unknown format: %s\n", optarg);
+					return 1;
+				}
+				break;
+			case 'j': options.format = (strcmp(optarg, "true") == 0) ? OUTPUT_JSON : OUTPUT_TEXT; break;
+			case 'e':
+				if (strcmp(optarg, "dfs") != 0 && strcmp(optarg, "frontier") != 0) {
+					fprintf(stderr, "Unknown engine: %s\n", optarg);
+					return 1;
+				}
+				options.useFrontier = (strcmp(optarg, "frontier") == 0);
+				break;
+			case 'n': options.numa = (strcmp(optarg, "true") == 0); break;
+			case 'm': setReachabilityMemo(strcmp(optarg, "true") == 0); break;
+			case 't': options.showStats = (strcmp(optarg, "true") == 0); break;
+			case 'f': options.showPerf = (strcmp(optarg, "true") == 0); break;
+			case 'u':
+			case 'a':
+				if (opt == 'u' ? !addCell(optarg, &options.constraints.mustUse, &options.constraints.numMustUse)
+							   : !addCell(optarg, &options.constraints.avoid, &options.constraints.numAvoid)) {
+					fprintf(stderr, "Invalid cell: %s (expected row,col)\n", optarg);
+					return 1;
+				}
+				break;
+			case 'l': options.constraints.minLength = atoi(optarg); break;
+			case 'L': options.constraints.maxLength = atoi(optarg); break;
+			case 'R':
+				if (!addRequiredLetters(optarg, &options.constraints.requiredLetters)) {
+					fprintf(stderr, "Invalid letters: %s\n", optarg);
+					return 1;
+				}
+				break;
+			case 'b': options.batch = (strcmp(optarg, "true") == 0); break;
+			case 'c': options.cacheDir = optarg; break;
+			case 'C': options.cacheSizeMb = atoll(optarg); break;
+			case 'p': options.planOptions.turns = atoi(optarg); break;
+			case 'k': options.planOptions.numCandidates = atoi(optarg); break;
+			case 'r': options.planOptions.rollouts = atoi(optarg); break;
+			case 'S': options.planOptions.seed = strtoull(optarg, NULL, 10); break;
 			default: fprintf(stderr, "Invalid option\n"); return 1;
 		}
 	}
 
-	Grid *grid = createGrid(gridSize);
+	if (!validateConstraints(&options))
+		return 1;
+
+	if (options.showPerf)
+		perfCounters = openPerfCounters();
+
+	if (options.batch) {
+		int status = runBatch(&options, gridFile);
+		printStats(&options);
+		closePhases();
+		freeThreadScratch();
+		freeConstraints(&options);
+		return status;
+	}
+
+	// Constrained queries are answered by the full search and are not cached
+	bool constrained = isConstrained(&options);
+	bool useCache = options.cacheDir != NULL && options.planOptions.turns <= 1 && !constrained;
+	bool pipelined = options.patchFile == NULL && options.planOptions.turns <= 1 && !options.useFrontier &&
+					 !options.numa && !constrained && options.numDicts == 1;
+
+	// Build the dictionary in the background while the grid is parsed, unless a cache hit might make it unnecessary
+	DictionaryLoader *loader = NULL;
+	if (pipelined && !useCache) {
+		loader = startDictionaryLoad(options.dictFiles[0], options.maxWordLength);
+	}
+
+	enterPhase("grid");
+	Grid *grid = createGrid(options.gridSize);
 	loadGrid(gridFile, grid);
 
-	TrieNode *trie = loadDictionary(dictFile, maxWordLength);
-
-	DynamicWordArray words = findWords(grid, trie, maxWordLength, maxSwaps);
-
-	// Find best words for each number of swaps
-	WordResult *bestResults = calloc(maxSwaps + 1, sizeof(WordResult));
-	for (int i = 0; i <= maxSwaps; i++) {
-		bestResults[i].word = NULL;
-		bestResults[i].positions = NULL;
-		bestResults[i].swapPositions = NULL;
-		bestResults[i].score = 0;
-	}
-
-	for (int i = 0; i < words.size; i++) {
-		int swaps = words.array[i].numSwaps;
-		if (swaps <= maxSwaps && words.array[i].score > bestResults[swaps].score) {
-			if (bestResults[swaps].word != NULL) {
-				freeWordResult(&bestResults[swaps]);
-			}
-			bestResults[swaps] = words.array[i];
-
-			// Create deep copy of the word result
-			bestResults[swaps].word = strdup(words.array[i].word);
-			bestResults[swaps].positions = malloc(words.array[i].length * sizeof(Position));
-			memcpy(bestResults[swaps].positions, words.array[i].positions, words.array[i].length * sizeof(Position));
-			bestResults[swaps].swapPositions = malloc(words.array[i].numSwaps * sizeof(Position));
-			memcpy(bestResults[swaps].swapPositions, words.array[i].swapPositions, words.array[i].numSwaps * sizeof(Position));
-		}
+	// A cache hit skips the dictionary load and the search entirely
+	uint64_t cacheKey = 0;
+	if (useCache && serveFromCache(&options, grid, solveFingerprint(&options), &cacheKey)) {
+		closePhases();
+		freeGrid(grid);
+		freeConstraints(&options);
+		return 0;
 	}
 
-	outputResults(bestResults, maxSwaps, grid, useJson);
+	if (pipelined) {
+		if (loader == NULL) {
+			loader = startDictionaryLoad(options.dictFiles[0], options.maxWordLength);
+		}
 
-	// Free allocated memory
-	freeDynamicWordArray(&words);
-	for (int i = 0; i <= maxSwaps; i++) {
-		if (bestResults[i].word != NULL) {
-			freeWordResult(&bestResults[i]);
+		// Find best words for each number of swaps, starting as soon as the first subtries are ready
+		enterPhase("search");
+		WordResult *bestResults = findBestResultsWhileLoading(grid, loader, options.maxWordLength, options.maxSwaps);
+		finishSolve(&options, grid, bestResults, cacheKey);
+		enterPhase("dictionary");
+		TrieNode *trie = finishDictionaryLoad(loader);
+		enterPhase("cleanup");
+		freeTrie(trie);
+	} else {
+		enterPhase("dictionary");
+		TrieNode *trie = loadDictionaries(options.dictFiles, options.numDicts, options.maxWordLength);
+		if (options.patchFile != NULL) {
+			int removed;
+			applyPatch(trie, &options, NULL, &removed);
 		}
+		TrieReplicas *replicas = NULL;
+		if (options.numa) {
+			replicas = createTrieReplicas(trie, true);
+			pinSearchThreads(replicas);
+		}
+		solveWithTrie(&options, grid, trie, replicas, cacheKey);
+		enterPhase("cleanup");
+		if (replicas != NULL)
+			freeTrieReplicas(replicas);
+		freeTrie(trie);
 	}
-	free(bestResults);
-	freeTrie(trie);
+
+	closePhases();
+	printStats(&options);
+
+	// Free allocated memory
+	freeThreadScratch();
 	freeGrid(grid);
+	freeConstraints(&options);
 
 	return 0;
 }
\ No newline at end of file
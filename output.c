@@ -1,5 +1,8 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "output.h"
+#include "binary_results.h"
 
 static void printGridWithHighlights(const Grid *grid, const Position *positions, int wordLength,
 									const Position *swapPositions, int numSwaps, const char *word) {
@@ -36,37 +39,208 @@ static void printGridWithHighlights(const Grid *grid, const Position *positions,
 	}
 }
 
-void outputResults(const WordResult *bestResults, int maxSwaps, const Grid *grid, bool useJson) {
+// Prints a JSON string literal, escaping quotes, backslashes and control characters
+static void printJsonString(const char *s) {
+	putchar('"');
+	for (; *s; s++) {
+		unsigned char c = (unsigned char)*s;
+		if (c == '"' || c == '\\')
+			printf("\\%c", c);
+		else if (c < 0x20)
+			printf("\\u%04x", c);
+		else
+			putchar(c);
+	}
+	putchar('"');
+}
+
+// Prints the results as a JSON array with every line but the first indented by indent
+static void printJsonResults(const WordResult *bestResults, int maxSwaps, const char *indent) {
+	printf("[\n");
+	for (int i = 0; i <= maxSwaps; i++) {
+		if (i > 0) printf(",\n");
+		printf("%s  {\n", indent);
+		printf("%s    \"swaps\": %d,\n", indent, i);
+		if (bestResults[i].word != NULL)
+			printf("%s    \"word\": \"%s\",\n", indent, bestResults[i].word);
+		else
+			printf("%s    \"word\": null,\n", indent);
+		printf("%s    \"score\": %d,\n", indent, bestResults[i].score);
+		printf("%s    \"positions\": [", indent);
+		for (int j = 0; j < bestResults[i].length; j++) {
+			if (j > 0) printf(", ");
+			printf("[%d, %d]", bestResults[i].positions[j].row, bestResults[i].positions[j].col);
+		}
+		printf("],\n");
+		printf("%s    \"swap_positions\": [", indent);
+		for (int j = 0; j < bestResults[i].numSwaps; j++) {
+			if (j > 0) printf(", ");
+			printf("[%d, %d]", bestResults[i].swapPositions[j].row, bestResults[i].swapPositions[j].col);
+		}
+		printf("]\n%s  }", indent);
+	}
+	printf("\n%s]", indent);
+}
+
+static void printTextResults(const WordResult *bestResults, int maxSwaps, const Grid *grid) {
+	for (int i = 0; i <= maxSwaps; i++) {
+		if (i > 0) printf("\n");
+		printf("For %d swap%s:\n", i, i == 1 ? "" : "s");
+		printf("Word: %s\n", bestResults[i].word != NULL ? bestResults[i].word : "(none)");
+		printf("Score: %d\n", bestResults[i].score);
+		printGridWithHighlights(grid, bestResults[i].positions, bestResults[i].length,
+								bestResults[i].swapPositions, bestResults[i].numSwaps, bestResults[i].word);
+	}
+}
+
+void outputResults(const WordResult *bestResults, int maxSwaps, const Grid *grid, OutputFormat format) {
+	if (format == OUTPUT_BINARY) {
+		writeBinaryResults(bestResults, 1, maxSwaps, grid, stdout);
+	} else if (format == OUTPUT_JSON) {
+		printJsonResults(bestResults, maxSwaps, "");
+		printf("\n");
+	} else {
+		printTextResults(bestResults, maxSwaps, grid);
+	}
+}
+
+void outputListResults(const WordResult *results, int numLists, const char *const *listNames, int maxSwaps,
+					   const Grid *grid, OutputFormat format) {
+	if (format == OUTPUT_BINARY) {
+		writeBinaryResults(results, numLists, maxSwaps, grid, stdout);
+	} else if (format == OUTPUT_JSON) {
+		printf("[\n");
+		for (int list = 0; list < numLists; list++) {
+			if (list > 0) printf(",\n");
+			printf("  {\n");
+			printf("    \"dictionary\": ");
+			printJsonString(listNames[list]);
+			printf(",\n");
+			printf("    \"results\": ");
+			printJsonResults(&results[list * (maxSwaps + 1)], maxSwaps, "    ");
+			printf("\n  }");
+		}
+		printf("\n]\n");
+	} else {
+		for (int list = 0; list < numLists; list++) {
+			if (list > 0) printf("\n");
+			printf("== %s ==\n", listNames[list]);
+			printTextResults(&results[list * (maxSwaps + 1)], maxSwaps, grid);
+		}
+	}
+}
+
+static uint16_t cellIndex(const Grid *grid, Position position) {
+	return (uint16_t)(position.row * grid->size + position.col);
+}
+
+void writeBinaryResults(const WordResult *results, int numLists, int maxSwaps, const Grid *grid, FILE *out) {
+	int numRecords = numLists * (maxSwaps + 1);
+	int cellSlots = 0;
+	int swapSlots = 0;
+	size_t stringsSize = 1; // Offset 0 is the empty word of records without one
+	for (int i = 0; i < numRecords; i++) {
+		if (results[i].word == NULL)
+			continue;
+		if (results[i].length > cellSlots)
+			cellSlots = results[i].length;
+		if (results[i].numSwaps > swapSlots)
+			swapSlots = results[i].numSwaps;
+		stringsSize += results[i].length + 1;
+	}
+
+	// Records and result sets are padded so that every field stays aligned
+	size_t recordSize = (sizeof(BinaryResultRecord) + (cellSlots + swapSlots) * sizeof(uint16_t) + 3) & ~(size_t)3;
+	size_t stringsOffset = sizeof(BinaryResultsHeader) + numRecords * recordSize;
+	size_t totalSize = (stringsOffset + stringsSize + 7) & ~(size_t)7;
+	char *buffer = calloc(1, totalSize);
+	if (!buffer) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+
+	BinaryResultsHeader *header = (BinaryResultsHeader *)buffer;
+	memcpy(header->magic, BINARY_RESULTS_MAGIC, 4);
+	header->version = BINARY_RESULTS_VERSION;
+	header->headerSize = sizeof(BinaryResultsHeader);
+	header->totalSize = totalSize;
+	header->numRecords = numRecords;
+	header->recordSize = recordSize;
+	header->cellSlots = cellSlots;
+	header->swapSlots = swapSlots;
+	header->gridSize = grid->size;
+	header->numLists = numLists;
+	header->maxSwaps = maxSwaps;
+	header->stringsOffset = stringsOffset;
+	header->stringsSize = stringsSize;
+
+	char *strings = buffer + stringsOffset;
+	size_t used = 1;
+	for (int i = 0; i < numRecords; i++) {
+		const WordResult *result = &results[i];
+		BinaryResultRecord *record = (BinaryResultRecord *)(buffer + header->headerSize + i * recordSize);
+		record->score = result->score;
+		record->swaps = i % (maxSwaps + 1);
+		record->list = i / (maxSwaps + 1);
+		if (result->word == NULL)
+			continue;
+
+		record->length = result->length;
+		record->numSwaps = result->numSwaps;
+		record->wordOffset = used;
+		memcpy(strings + used, result->word, result->length);
+		used += result->length + 1;
+		for (int j = 0; j < result->length; j++) {
+			record->cells[j] = cellIndex(grid, result->positions[j]);
+		}
+		for (int j = 0; j < result->numSwaps; j++) {
+			record->cells[cellSlots + j] = cellIndex(grid, result->swapPositions[j]);
+		}
+	}
+
+	fwrite(buffer, 1, totalSize, out);
+	free(buffer);
+}
+
+static void printJsonPositions(const Position *positions, int count) {
+	printf("[");
+	for (int j = 0; j < count; j++) {
+		if (j > 0) printf(", ");
+		printf("[%d, %d]", positions[j].row, positions[j].col);
+	}
+	printf("]");
+}
+
+void outputPlan(const PlanCandidate *candidates, int numCandidates, const Grid *grid, bool useJson) {
 	if (useJson) {
 		printf("[\n");
-		for (int i = 0; i <= maxSwaps; i++) {
+		for (int i = 0; i < numCandidates; i++) {
+			const WordResult *result = &candidates[i].result;
 			if (i > 0) printf(",\n");
 			printf("  {\n");
-			printf("    \"swaps\": %d,\n", i);
-			printf("    \"word\": \"%s\",\n", bestResults[i].word);
-			printf("    \"score\": %d,\n", bestResults[i].score);
-			printf("    \"positions\": [");
-			for (int j = 0; j < bestResults[i].length; j++) {
-				if (j > 0) printf(", ");
-				printf("[%d, %d]", bestResults[i].positions[j].row, bestResults[i].positions[j].col);
-			}
-			printf("],\n");
-			printf("    \"swap_positions\": [");
-			for (int j = 0; j < i; j++) {
-				if (j > 0) printf(", ");
-				printf("[%d, %d]", bestResults[i].swapPositions[j].row, bestResults[i].swapPositions[j].col);
-			}
-			printf("]\n  }");
+			printf("    \"swaps\": %d,\n", result->numSwaps);
+			printf("    \"word\": \"%s\",\n", result->word);
+			printf("    \"score\": %d,\n", result->score);
+			printf("    \"future_score\": %.2f,\n", candidates[i].futureScore);
+			printf("    \"expected_score\": %.2f,\n", candidates[i].expectedScore);
+			printf("    \"positions\": ");
+			printJsonPositions(result->positions, result->length);
+			printf(",\n    \"swap_positions\": ");
+			printJsonPositions(result->swapPositions, result->numSwaps);
+			printf("\n  }");
 		}
 		printf("\n]\n");
 	} else {
-		for (int i = 0; i <= maxSwaps; i++) {
-			if (i > 0) printf("\n");
-			printf("For %d swap%s:\n", i, i == 1 ? "" : "s");
-			printf("Word: %s\n", bestResults[i].word);
-			printf("Score: %d\n", bestResults[i].score);
-			printGridWithHighlights(grid, bestResults[i].positions, bestResults[i].length,
-									bestResults[i].swapPositions, i, bestResults[i].word);
+		for (int i = 0; i < numCandidates; i++) {
+			const WordResult *result = &candidates[i].result;
+			printf("%d. %s (%d swap%s): score %d, expected %.2f\n", i + 1, result->word, result->numSwaps,
+				   result->numSwaps == 1 ? "" : "s", result->score, candidates[i].expectedScore);
+		}
+		if (numCandidates > 0) {
+			printf("\n");
+			printGridWithHighlights(grid, candidates[0].result.positions, candidates[0].result.length,
+									candidates[0].result.swapPositions, candidates[0].result.numSwaps,
+									candidates[0].result.word);
 		}
 	}
 }
\ No newline at end of file
@@ -2,8 +2,16 @@
 #define OUTPUT_H
 
 #include <stdbool.h>
+#include <stdio.h>
 #include "word_finder.h"
 #include "grid.h"
+#include "planner.h"
+
+typedef enum {
+	OUTPUT_TEXT,
+	OUTPUT_JSON,
+	OUTPUT_BINARY // The layout of binary_results.h
+} OutputFormat;
 
 /**
  * Outputs the results of the word finding and optimization process.
@@ -11,8 +19,45 @@
  * @param bestResults Array of the best WordResults for each number of swaps.
  * @param maxSwaps The maximum number of swaps allowed.
  * @param grid The game grid.
+ * @param format The output format.
+ */
+void outputResults(const WordResult *bestResults, int maxSwaps, const Grid *grid, OutputFormat format);
+
+/**
+ * Outputs the best results of several word lists, one section per list.
+ *
+ * @param results The results of findBestResultsPerList(), maxSwaps + 1 per list.
+ * @param numLists The number of word lists.
+ * @param listNames The name shown for each list.
+ * @param maxSwaps The maximum number of swaps allowed.
+ * @param grid The game grid.
+ * @param format The output format; the binary format records only the list index.
+ */
+void outputListResults(const WordResult *results, int numLists, const char *const *listNames, int maxSwaps,
+					   const Grid *grid, OutputFormat format);
+
+/**
+ * Writes results as one binary result set (see binary_results.h).
+ *
+ * The set is built in memory and written with a single fwrite(), so result sets of a
+ * batch run never interleave.
+ *
+ * @param results The best results, maxSwaps + 1 per list.
+ * @param numLists The number of word lists.
+ * @param maxSwaps The maximum number of swaps allowed.
+ * @param grid The game grid.
+ * @param out The stream to write to.
+ */
+void writeBinaryResults(const WordResult *results, int numLists, int maxSwaps, const Grid *grid, FILE *out);
+
+/**
+ * Outputs the candidates ranked by the multi-turn planner.
+ *
+ * @param candidates Array of candidates sorted by expected score.
+ * @param numCandidates The number of candidates.
+ * @param grid The game grid.
  * @param useJson Whether to output in JSON format.
  */
-void outputResults(const WordResult *bestResults, int maxSwaps, const Grid *grid, bool useJson);
+void outputPlan(const PlanCandidate *candidates, int numCandidates, const Grid *grid, bool useJson);
 
 #endif // OUTPUT_H
\ No newline at end of file
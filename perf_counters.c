@@ -0,0 +1,162 @@
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <omp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include "perf_counters.h"
+
+const char *PERF_EVENT_NAMES[NUM_PERF_EVENTS] = {
+	"cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "context_switches"
+};
+
+static const struct {
+	uint32_t type;
+	uint64_t config;
+} PERF_EVENT_CONFIGS[NUM_PERF_EVENTS] = {
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+	{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+						 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+	{PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES}
+};
+
+struct PerfCounters {
+	int numThreads;
+	int fds[MAX_PERF_THREADS][NUM_PERF_EVENTS];     // -1 where the event could not be opened
+	uint64_t start[MAX_PERF_THREADS][NUM_PERF_EVENTS];
+	struct timespec startTime;
+};
+
+// Counts the calling thread only, on any CPU
+static int openEvent(PerfEvent event) {
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_EVENT_CONFIGS[event].type;
+	attr.config = PERF_EVENT_CONFIGS[event].config;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	// Context switches happen in the kernel, and counting them is allowed without privileges
+	attr.exclude_kernel = event != PERF_CONTEXT_SWITCHES;
+	attr.exclude_hv = 1;
+	return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// The event's count so far, extrapolated over the time it was multiplexed out
+static uint64_t readEvent(int fd) {
+	uint64_t values[3];
+	if (fd < 0 || read(fd, values, sizeof(values)) != sizeof(values) || values[2] == 0)
+		return 0;
+	if (values[2] >= values[1])
+		return values[0];
+	return (uint64_t)((double)values[0] * values[1] / values[2]);
+}
+
+PerfCounters* openPerfCounters(void) {
+	PerfCounters *counters = calloc(1, sizeof(PerfCounters));
+	if (!counters) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	for (int t = 0; t < MAX_PERF_THREADS; t++) {
+		for (int e = 0; e < NUM_PERF_EVENTS; e++) {
+			counters->fds[t][e] = -1;
+		}
+	}
+
+	int errors[NUM_PERF_EVENTS] = {0};
+	#pragma omp parallel
+	{
+		int t = omp_get_thread_num();
+		if (t < MAX_PERF_THREADS) {
+			for (int e = 0; e < NUM_PERF_EVENTS; e++) {
+				counters->fds[t][e] = openEvent(e);
+				if (counters->fds[t][e] < 0) {
+					#pragma omp critical
+					errors[e] = errno;
+				}
+			}
+		}
+		#pragma omp single
+		counters->numThreads = omp_get_num_threads() < MAX_PERF_THREADS ? omp_get_num_threads() : MAX_PERF_THREADS;
+	}
+
+	int lastError = 0;
+	for (int e = 0; e < NUM_PERF_EVENTS; e++) {
+		if (errors[e] == 0)
+			continue;
+		fprintf(stderr, "%s%s", lastError ? ", " : "Performance counters unavailable: ", PERF_EVENT_NAMES[e]);
+		lastError = errors[e];
+	}
+	if (lastError)
+		fprintf(stderr, " (%s)\n", strerror(lastError));
+	return counters;
+}
+
+void beginPerfPhase(PerfCounters *counters) {
+	for (int t = 0; t < counters->numThreads; t++) {
+		for (int e = 0; e < NUM_PERF_EVENTS; e++) {
+			counters->start[t][e] = readEvent(counters->fds[t][e]);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &counters->startTime);
+}
+
+PerfSample endPerfPhase(PerfCounters *counters) {
+	PerfSample sample;
+	memset(&sample, 0, sizeof(sample));
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	sample.wallMs = (end.tv_sec - counters->startTime.tv_sec) * 1e3 +
+					(end.tv_nsec - counters->startTime.tv_nsec) / 1e6;
+	sample.numThreads = counters->numThreads;
+
+	for (int t = 0; t < counters->numThreads; t++) {
+		for (int e = 0; e < NUM_PERF_EVENTS; e++) {
+			if (counters->fds[t][e] < 0)
+				continue;
+			uint64_t value = readEvent(counters->fds[t][e]);
+			uint64_t delta = value > counters->start[t][e] ? value - counters->start[t][e] : 0;
+			sample.available[e] = true;
+			sample.totals[e] += delta;
+			if (e == PERF_CONTEXT_SWITCHES)
+				sample.threadContextSwitches[t] = delta;
+		}
+	}
+	return sample;
+}
+
+void printPerfSample(FILE *out, const char *phase, const PerfSample *sample) {
+	fprintf(out, "{\"phase\": \"%s\", \"wall_ms\": %.3f", phase, sample->wallMs);
+	for (int e = 0; e < NUM_PERF_EVENTS; e++) {
+		if (sample->available[e])
+			fprintf(out, ", \"%s\": %llu", PERF_EVENT_NAMES[e], (unsigned long long)sample->totals[e]);
+		else
+			fprintf(out, ", \"%s\": null", PERF_EVENT_NAMES[e]);
+	}
+	fprintf(out, ", \"thread_context_switches\": ");
+	if (sample->available[PERF_CONTEXT_SWITCHES]) {
+		fprintf(out, "[");
+		for (int t = 0; t < sample->numThreads; t++) {
+			fprintf(out, "%s%llu", t > 0 ? ", " : "", (unsigned long long)sample->threadContextSwitches[t]);
+		}
+		fprintf(out, "]");
+	} else {
+		fprintf(out, "null");
+	}
+	fprintf(out, "}\n");
+}
+
+void closePerfCounters(PerfCounters *counters) {
+	for (int t = 0; t < counters->numThreads; t++) {
+		for (int e = 0; e < NUM_PERF_EVENTS; e++) {
+			if (counters->fds[t][e] >= 0)
+				close(counters->fds[t][e]);
+		}
+	}
+	free(counters);
+}
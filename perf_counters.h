@@ -0,0 +1,81 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Threads whose counters are kept apart
+#define MAX_PERF_THREADS 256
+
+typedef enum {
+	PERF_CYCLES,
+	PERF_INSTRUCTIONS,
+	PERF_L1D_MISSES,
+	PERF_LLC_MISSES,
+	PERF_BRANCH_MISSES,
+	PERF_CONTEXT_SWITCHES,
+	NUM_PERF_EVENTS
+} PerfEvent;
+
+// Names used in the machine-readable output, indexed by PerfEvent
+extern const char *PERF_EVENT_NAMES[NUM_PERF_EVENTS];
+
+// Counts of one phase, summed over the counted threads
+typedef struct {
+	double wallMs;
+	bool available[NUM_PERF_EVENTS]; // False where the kernel or hardware does not provide the event
+	uint64_t totals[NUM_PERF_EVENTS];
+	int numThreads;
+	uint64_t threadContextSwitches[MAX_PERF_THREADS];
+} PerfSample;
+
+typedef struct PerfCounters PerfCounters;
+
+/**
+ * Opens per-thread hardware and software counters with perf_event_open().
+ *
+ * Each thread of the OpenMP team opens its own counters, so threads started later
+ * (such as the dictionary loader's) are not counted. Only user-space events are
+ * counted, except for context switches. Events the kernel, the hardware or the
+ * permissions do not provide are marked unavailable, with one warning on stderr;
+ * the counters can still be used and report wall time and whatever remains.
+ *
+ * @return The counters, to be released with closePerfCounters().
+ */
+PerfCounters* openPerfCounters(void);
+
+/**
+ * Starts a phase by taking a snapshot of every counter.
+ *
+ * @param counters The counters.
+ */
+void beginPerfPhase(PerfCounters *counters);
+
+/**
+ * Ends the phase started by the last beginPerfPhase().
+ *
+ * Counts are scaled up when the kernel had to multiplex the events.
+ *
+ * @param counters The counters.
+ * @return What was counted during the phase.
+ */
+PerfSample endPerfPhase(PerfCounters *counters);
+
+/**
+ * Prints a sample as one line of JSON, with null for unavailable events.
+ *
+ * @param out The stream to print to.
+ * @param phase The name of the phase.
+ * @param sample The sample to print.
+ */
+void printPerfSample(FILE *out, const char *phase, const PerfSample *sample);
+
+/**
+ * Closes the counters and frees them.
+ *
+ * @param counters The counters.
+ */
+void closePerfCounters(PerfCounters *counters);
+
+#endif // PERF_COUNTERS_H
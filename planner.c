@@ -0,0 +1,130 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "planner.h"
+
+// Played tiles are replaced in place by fresh random letters without multipliers
+static void playWord(Grid *grid, const WordResult *word, uint64_t *rng) {
+	for (int i = 0; i < word->length; i++) {
+		int index = word->positions[i].row * grid->size + word->positions[i].col;
+		grid->letters[index] = randomGridLetter(rng);
+		grid->letterMultiplier[index] = 1;
+		grid->wordMultiplier[index] = 1;
+	}
+}
+
+static double simulateRollout(const Grid *grid, TrieNode *trie, int maxWordLength, int maxSwaps,
+							  const WordResult *first, int turns, Grid *board, SearchScratch *scratch, uint64_t *rng) {
+	copyGrid(board, grid);
+	playWord(board, first, rng);
+
+	int swapsLeft = maxSwaps - first->numSwaps;
+	double total = 0;
+	for (int turn = 1; turn < turns; turn++) {
+		const WordResult *best = findBestWords(board, trie, maxWordLength, swapsLeft, scratch);
+
+		// Greedy policy: the highest scoring word, spending as few swaps as possible for it
+		int choice = 0;
+		for (int i = 1; i <= swapsLeft; i++) {
+			if (best[i].score > best[choice].score)
+				choice = i;
+		}
+		if (best[choice].score == 0)
+			break;
+
+		total += best[choice].score;
+		swapsLeft -= choice;
+		if (turn + 1 < turns)
+			playWord(board, &best[choice], rng);
+	}
+	return total;
+}
+
+static int compareByScore(const void *a, const void *b) {
+	const WordResult *wa = *(const WordResult *const *)a;
+	const WordResult *wb = *(const WordResult *const *)b;
+	return (wb->score > wa->score) - (wb->score < wa->score);
+}
+
+static int compareByExpectedScore(const void *a, const void *b) {
+	const PlanCandidate *ca = a;
+	const PlanCandidate *cb = b;
+	return (cb->expectedScore > ca->expectedScore) - (cb->expectedScore < ca->expectedScore);
+}
+
+static int selectCandidates(const DynamicWordArray *words, int maxCandidates, PlanCandidate *candidates) {
+	const WordResult **sorted = malloc(words->size * sizeof(WordResult *));
+	for (int i = 0; i < words->size; i++) {
+		sorted[i] = &words->array[i];
+	}
+	qsort(sorted, words->size, sizeof(WordResult *), compareByScore);
+
+	// Keep the best path of each distinct word
+	int count = 0;
+	for (int i = 0; i < words->size && count < maxCandidates; i++) {
+		bool duplicate = false;
+		for (int j = 0; j < count && !duplicate; j++) {
+			duplicate = strcmp(candidates[j].result.word, sorted[i]->word) == 0;
+		}
+		if (!duplicate) {
+			candidates[count].result = copyWordResult(sorted[i]);
+			candidates[count].futureScore = 0;
+			count++;
+		}
+	}
+
+	free(sorted);
+	return count;
+}
+
+PlanCandidate* planTurns(const Grid *grid, TrieNode *trie, int maxWordLength, int maxSwaps,
+						 const PlanOptions *options, int *numCandidates) {
+	DynamicWordArray words = findWords(grid, trie, maxWordLength, maxSwaps);
+	PlanCandidate *candidates = calloc(options->numCandidates > 0 ? options->numCandidates : 1, sizeof(PlanCandidate));
+	if (!candidates) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	int count = selectCandidates(&words, options->numCandidates, candidates);
+	freeDynamicWordArray(&words);
+
+	int rollouts = options->rollouts;
+	#pragma omp parallel
+	{
+		Grid *board = createGrid(grid->size);
+		SearchScratch *scratch = createSearchScratch(grid->size, maxWordLength, maxSwaps);
+
+		#pragma omp for collapse(2) schedule(dynamic)
+		for (int c = 0; c < count; c++) {
+			for (int r = 0; r < rollouts; r++) {
+				// Seeding per (candidate, rollout) keeps results independent of the thread count
+				uint64_t rng = options->seed ^ ((uint64_t)c * rollouts + r) * 0xD1B54A32D192ED03ULL;
+				double score = simulateRollout(grid, trie, maxWordLength, maxSwaps, &candidates[c].result,
+											   options->turns, board, scratch, &rng);
+				#pragma omp atomic
+				candidates[c].futureScore += score;
+			}
+		}
+
+		freeSearchScratch(scratch);
+		freeGrid(board);
+	}
+
+	for (int c = 0; c < count; c++) {
+		if (rollouts > 0)
+			candidates[c].futureScore /= rollouts;
+		candidates[c].expectedScore = candidates[c].result.score + candidates[c].futureScore;
+	}
+	qsort(candidates, count, sizeof(PlanCandidate), compareByExpectedScore);
+
+	*numCandidates = count;
+	return candidates;
+}
+
+void freePlanCandidates(PlanCandidate *candidates, int numCandidates) {
+	for (int i = 0; i < numCandidates; i++) {
+		freeWordResult(&candidates[i].result);
+	}
+	free(candidates);
+}
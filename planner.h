@@ -0,0 +1,50 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include "grid.h"
+#include "trie.h"
+#include "word_finder.h"
+
+#define DEFAULT_PLAN_CANDIDATES 8
+#define DEFAULT_PLAN_ROLLOUTS 200
+
+typedef struct {
+	int turns;              // Planning horizon, including the current turn
+	int numCandidates;      // How many of the best current-turn words to evaluate
+	int rollouts;           // Random continuations sampled per candidate
+	unsigned long long seed;
+} PlanOptions;
+
+typedef struct {
+	WordResult result;      // The word played on the current turn
+	double futureScore;     // Mean score of the greedy continuation turns
+	double expectedScore;   // result.score + futureScore
+} PlanCandidate;
+
+/**
+ * Ranks the best current-turn words by expected score over several turns.
+ *
+ * Each candidate's tiles are removed and refilled with random letters, then the
+ * following turns are played greedily with findBestWords(), sharing the swap budget
+ * across the whole horizon. Rollouts run in parallel, one scratch per thread.
+ *
+ * @param grid The game grid.
+ * @param trie The Trie containing the dictionary.
+ * @param maxWordLength The maximum allowed word length.
+ * @param maxSwaps The swap budget for the whole planning horizon.
+ * @param options The planning options.
+ * @param numCandidates Set to the number of returned candidates.
+ * @return An array of candidates sorted by expected score, best first.
+ */
+PlanCandidate* planTurns(const Grid *grid, TrieNode *trie, int maxWordLength, int maxSwaps,
+						 const PlanOptions *options, int *numCandidates);
+
+/**
+ * Frees an array of candidates returned by planTurns().
+ *
+ * @param candidates The array of candidates.
+ * @param numCandidates The number of candidates in the array.
+ */
+void freePlanCandidates(PlanCandidate *candidates, int numCandidates);
+
+#endif // PLANNER_H
@@ -0,0 +1,38 @@
+#!/bin/sh
+# Runs the solver over every board in the PGO corpus at 0-2 swaps.
+#
+# Usage: corpus.sh <binary>                                  Run the corpus once (training)
+#        corpus.sh --compare <plain> <optimized> [repeats]   Time both binaries and report the speedup
+
+CORPUS_DIR=$(dirname "$0")
+
+run_corpus() {
+	for board in "$CORPUS_DIR"/board*.txt; do
+		size=$(wc -l < "$board")
+		for swaps in 0 1 2; do
+			"$1" "$board" --gridsize "$size" --maxswaps "$swaps" > /dev/null || exit 1
+		done
+	done
+}
+
+time_corpus() {
+	start=$(date +%s.%N)
+	i=0
+	while [ "$i" -lt "$2" ]; do
+		run_corpus "$1"
+		i=$((i + 1))
+	done
+	end=$(date +%s.%N)
+	echo "$start $end" | awk '{ printf "%.3f", $2 - $1 }'
+}
+
+if [ "$1" = "--compare" ]; then
+	repeats=${4:-3}
+	plain=$(time_corpus "$2" "$repeats")
+	optimized=$(time_corpus "$3" "$repeats")
+	echo "Plain build:     ${plain}s"
+	echo "PGO + LTO build: ${optimized}s"
+	echo "$plain $optimized" | awk '{ printf "Speedup:         %.2fx\n", $1 / $2 }'
+else
+	run_corpus "$1"
+fi
@@ -2,11 +2,22 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <ctype.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
 #include "grid.h"
 #include "trie.h"
 #include "word_finder.h"
+#include "cache.h"
+#include "planner.h"
+#include "frontier.h"
+#include "topology.h"
+#include "perf_counters.h"
+#include "output.h"
+#include "binary_results.h"
 
 #define TEST(name) void test_##name()
 #define RUN_TEST(name) printf("Running %s...\n", #name); test_##name(); printf("%s passed\n", #name)
@@ -32,6 +43,43 @@ char* create_temp_file(const char* content) {
 	return strdup(template);
 }
 
+// Words the CAT / DOG / RAT board spells; CODGART runs through seven of its cells
+const char* CAT_DOG_RAT_WORDS[] = {"CAT", "COT", "DOG", "GOAT", "TOGA", "RAT", "TAR", "ART", "COD", "CODGART"};
+
+/**
+ * Creates the 3x3 board the search tests share, with rows CAT, DOG and RAT.
+ *
+ * @param trie If not NULL, set to a new Trie of the CAT_DOG_RAT_WORDS that fit maxWordLength.
+ * @param maxWordLength The maximum word length of the Trie.
+ * @return The board.
+ */
+Grid* makeCatDogRatFixture(TrieNode** trie, int maxWordLength) {
+	Grid* grid = createGrid(3);
+	char gridLetters[9] = {'C', 'A', 'T', 'D', 'O', 'G', 'R', 'A', 'T'};
+	memcpy(grid->letters, gridLetters, 9 * sizeof(char));
+
+	if (trie != NULL) {
+		*trie = createNode();
+		for (int i = 0; i < (int)(sizeof(CAT_DOG_RAT_WORDS) / sizeof(CAT_DOG_RAT_WORDS[0])); i++) {
+			if ((int)strlen(CAT_DOG_RAT_WORDS[i]) <= maxWordLength)
+				insertWord(*trie, CAT_DOG_RAT_WORDS[i], maxWordLength);
+		}
+	}
+	return grid;
+}
+
+// Whether an upper- or lowercase word is in the Trie
+bool trie_has_word(const TrieNode* root, const char* word) {
+	const TrieNode* node = root;
+	for (int i = 0; word[i]; i++) {
+		int index = toupper(word[i]) - 'A';
+		if (!(node->children & (1U << index)))
+			return false;
+		node = node->childPtrs[index];
+	}
+	return node->isWord != 0;
+}
+
 TEST(grid_creation) {
 	Grid *grid = createGrid(5);
 	assert(grid != NULL);
@@ -400,6 +448,756 @@ TEST(specific_word_finding) {
 	freeTrie(trie);
 }
 
+TEST(result_cache) {
+	char cacheDir[] = "/tmp/cachetest_XXXXXX";
+	assert(mkdtemp(cacheDir) != NULL);
+
+	Grid *grid = makeCatDogRatFixture(NULL, 0);
+
+	TrieNode *trie = createNode();
+	insertWord(trie, "CAT", 3);
+	insertWord(trie, "COT", 3);
+
+	DynamicWordArray words = findWords(grid, trie, 3, 1);
+	WordResult *bestResults = selectBestResults(&words, 1);
+
+	uint64_t key = computeCacheKey(grid, 3, 1, 42);
+	assert(loadCachedResults(cacheDir, key, grid, 1) == NULL);
+	storeCachedResults(cacheDir, key, bestResults, grid, 1, 0);
+
+	WordResult *cached = loadCachedResults(cacheDir, key, grid, 1);
+	assert(cached != NULL);
+	for (int i = 0; i <= 1; i++) {
+		assert(strcmp(cached[i].word, bestResults[i].word) == 0);
+		assert(cached[i].score == bestResults[i].score);
+		assert(cached[i].length == bestResults[i].length);
+		assert(cached[i].numSwaps == bestResults[i].numSwaps);
+		assert(memcmp(cached[i].positions, bestResults[i].positions, cached[i].length * sizeof(Position)) == 0);
+		assert(memcmp(cached[i].swapPositions, bestResults[i].swapPositions, cached[i].numSwaps * sizeof(Position)) == 0);
+	}
+	freeBestResults(cached, 1);
+
+	// An entry whose cells fall outside the grid is a miss
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/%016llx.scr", cacheDir, (unsigned long long)key);
+	FILE *entry = fopen(path, "r+b");
+	uint16_t badCell = 9;
+	fseek(entry, 24 + 4 + bestResults[0].length, SEEK_SET);
+	fwrite(&badCell, sizeof(badCell), 1, entry);
+	fclose(entry);
+	assert(loadCachedResults(cacheDir, key, grid, 1) == NULL);
+
+	// Any change to the grid or settings must produce a different key
+	assert(computeCacheKey(grid, 3, 0, 42) != key);
+	assert(computeCacheKey(grid, 3, 1, 43) != key);
+	grid->letterMultiplier[4] = 2;
+	assert(computeCacheKey(grid, 3, 1, 42) != key);
+
+	// Eviction removes temporary files that a crashed writer left behind, but not ones being written
+	char staleTemp[4096], freshTemp[4096];
+	snprintf(staleTemp, sizeof(staleTemp), "%s/.tmp-stale0", cacheDir);
+	snprintf(freshTemp, sizeof(freshTemp), "%s/.tmp-fresh0", cacheDir);
+	fclose(fopen(staleTemp, "w"));
+	fclose(fopen(freshTemp, "w"));
+	struct timespec old[2] = {{.tv_sec = time(NULL) - 2 * 3600}, {.tv_sec = time(NULL) - 2 * 3600}};
+	utimensat(AT_FDCWD, staleTemp, old, 0);
+	storeCachedResults(cacheDir, key + 2, bestResults, grid, 1, 1 << 20);
+	assert(access(staleTemp, F_OK) == -1);
+	assert(access(freshTemp, F_OK) == 0);
+	unlink(freshTemp);
+
+	// A tiny size bound evicts everything but keeps the directory usable
+	storeCachedResults(cacheDir, key + 1, bestResults, grid, 1, 1);
+	assert(loadCachedResults(cacheDir, key, grid, 1) == NULL);
+	assert(loadCachedResults(cacheDir, key + 1, grid, 1) == NULL);
+
+	freeBestResults(bestResults, 1);
+	freeDynamicWordArray(&words);
+	freeTrie(trie);
+	freeGrid(grid);
+	rmdir(cacheDir);
+}
+
+TEST(best_words_and_planning) {
+	TrieNode *trie;
+	Grid *grid = makeCatDogRatFixture(&trie, 4);
+	grid->wordMultiplier[4] = 2;
+
+	// The allocation-free search must agree with a full enumeration
+	DynamicWordArray words = findWords(grid, trie, 4, 2);
+	WordResult *expected = selectBestResults(&words, 2);
+	SearchScratch *scratch = createSearchScratch(3, 4, 2);
+	for (int repeat = 0; repeat < 2; repeat++) {
+		const WordResult *best = findBestWords(grid, trie, 4, 2, scratch);
+		for (int i = 0; i <= 2; i++) {
+			assert(best[i].score == expected[i].score);
+			assert(best[i].numSwaps == i);
+		}
+	}
+	freeSearchScratch(scratch);
+	freeBestResults(expected, 2);
+	freeDynamicWordArray(&words);
+
+	PlanOptions options = {.turns = 3, .numCandidates = 4, .rollouts = 20, .seed = 7};
+	int numCandidates = 0;
+	PlanCandidate *candidates = planTurns(grid, trie, 4, 1, &options, &numCandidates);
+	assert(numCandidates == 4);
+	for (int i = 0; i < numCandidates; i++) {
+		assert(candidates[i].expectedScore == candidates[i].result.score + candidates[i].futureScore);
+		if (i > 0)
+			assert(candidates[i].expectedScore <= candidates[i - 1].expectedScore);
+		for (int j = 0; j < i; j++)
+			assert(strcmp(candidates[i].result.word, candidates[j].result.word) != 0);
+	}
+
+	// Rollouts are seeded deterministically
+	int numRepeated = 0;
+	PlanCandidate *repeated = planTurns(grid, trie, 4, 1, &options, &numRepeated);
+	assert(numRepeated == numCandidates);
+	for (int i = 0; i < numCandidates; i++) {
+		bool found = false;
+		for (int j = 0; j < numRepeated; j++) {
+			if (strcmp(repeated[j].result.word, candidates[i].result.word) == 0)
+				found = repeated[j].futureScore == candidates[i].futureScore;
+		}
+		assert(found);
+	}
+
+	freePlanCandidates(repeated, numRepeated);
+	freePlanCandidates(candidates, numCandidates);
+	freeGrid(grid);
+	freeTrie(trie);
+}
+
+TEST(large_board_visited) {
+	TrieNode *trie = createNode();
+	insertWord(trie, "ABCDEFGHI", 9);
+	insertWord(trie, "HGH", 9);
+
+	// On a 9x9 board the path runs down column 1 from cell 1 to cell 64, across the boundary between
+	// the first two words of the visited bitset, and ends on cell 65, which a single word would mix up with cell 1
+	Grid *grid = createGrid(9);
+	memset(grid->letters, 'X', 81);
+	for (int row = 0; row < 8; row++) {
+		grid->letters[row * 9 + 1] = 'A' + row;
+	}
+	grid->letters[7 * 9 + 2] = 'I';
+
+	WordResult *results = findBestResults(grid, trie, 9, 0);
+	assert(results[0].word != NULL && strcmp(results[0].word, "ABCDEFGHI") == 0);
+	assert(results[0].positions[7].row == 7 && results[0].positions[7].col == 1);
+	assert(results[0].positions[8].row == 7 && results[0].positions[8].col == 2);
+	freeBestResults(results, 0);
+
+	// Cell 64 cannot be used twice in one path
+	DynamicWordArray words = findWords(grid, trie, 9, 0);
+	assert(words.size == 1 && strcmp(words.array[0].word, "ABCDEFGHI") == 0);
+	freeDynamicWordArray(&words);
+
+	freeGrid(grid);
+	freeTrie(trie);
+}
+
+TEST(frontier_engine) {
+	TrieNode *trie;
+	Grid *grid = makeCatDogRatFixture(&trie, 7);
+	grid->wordMultiplier[4] = 2;
+	grid->letterMultiplier[2] = 3;
+
+	// The batched engine must find the same best scores as the depth-first search
+	for (int maxSwaps = 0; maxSwaps <= 3; maxSwaps++) {
+		WordResult *expected = findBestResults(grid, trie, 7, maxSwaps);
+		WordResult *best = findBestResultsFrontier(grid, trie, 7, maxSwaps);
+		for (int i = 0; i <= maxSwaps; i++) {
+			assert(best[i].score == expected[i].score);
+			if (best[i].word == NULL)
+				continue;
+			assert(best[i].numSwaps == i);
+			assert(calculateWordScore(best[i].word, best[i].positions, grid) == best[i].score);
+			// Exactly the cells whose letter differs from the board are recorded as swaps
+			int numChanged = 0;
+			for (int j = 0; j < best[i].length; j++) {
+				Position p = best[i].positions[j];
+				if (grid->letters[p.row * 3 + p.col] != best[i].word[j]) {
+					assert(best[i].swapPositions[numChanged].row == p.row);
+					assert(best[i].swapPositions[numChanged].col == p.col);
+					numChanged++;
+				}
+			}
+			assert(numChanged == i);
+		}
+		freeBestResults(best, maxSwaps);
+		freeBestResults(expected, maxSwaps);
+	}
+
+	freeGrid(grid);
+	freeTrie(trie);
+}
+
+TEST(trie_replication) {
+	TrieNode *trie;
+	Grid *grid = makeCatDogRatFixture(&trie, 4);
+	removeWord(trie, "COD");
+	grid->wordMultiplier[4] = 2;
+
+	// A deep copy holds the same words in separate nodes
+	TrieNode *copy = copyTrie(trie);
+	assert(copy != trie && copy->childPtrs[2] != trie->childPtrs[2]);
+	WordResult *expected = findBestResults(grid, trie, 4, 2);
+	WordResult *copied = findBestResults(grid, copy, 4, 2);
+	for (int i = 0; i <= 2; i++) {
+		assert(copied[i].score == expected[i].score);
+	}
+	freeBestResults(copied, 2);
+	freeTrie(copy);
+
+	// Searching through the replicas gives the same results whether or not the trie is copied
+	for (int replicate = 0; replicate <= 1; replicate++) {
+		TrieReplicas *replicas = createTrieReplicas(trie, replicate);
+		assert(replicas->numNodes >= 1);
+		assert(replicas->replicated || replicas->roots[0] == trie);
+		assert(localReplica(replicas) != NULL);
+		WordResult *best = findBestResultsReplicated(grid, replicas, 4, 2);
+		for (int i = 0; i <= 2; i++) {
+			assert(best[i].score == expected[i].score);
+		}
+		freeBestResults(best, 2);
+		freeTrieReplicas(replicas);
+	}
+
+	freeBestResults(expected, 2);
+	freeGrid(grid);
+	freeTrie(trie);
+}
+
+// Reference for the constraint pushdown: the best word per swap count among all words that pass the filter
+static bool passesConstraints(const WordResult *word, const SearchConstraints *constraints) {
+	if (word->length < constraints->minLength || (constraints->maxLength > 0 && word->length > constraints->maxLength))
+		return false;
+	for (int letter = 0; letter < 26; letter++) {
+		if ((constraints->requiredLetters & (1U << letter)) && !strchr(word->word, 'A' + letter))
+			return false;
+	}
+	for (int i = 0; i < constraints->numMustUse + constraints->numAvoid; i++) {
+		bool mustUse = i < constraints->numMustUse;
+		Position cell = mustUse ? constraints->mustUse[i] : constraints->avoid[i - constraints->numMustUse];
+		bool used = false;
+		for (int j = 0; j < word->length; j++) {
+			used |= word->positions[j].row == cell.row && word->positions[j].col == cell.col;
+		}
+		if (used != mustUse)
+			return false;
+	}
+	return true;
+}
+
+TEST(search_constraints) {
+	TrieNode *trie;
+	Grid *grid = makeCatDogRatFixture(&trie, 7);
+	grid->wordMultiplier[4] = 2;
+
+	Position center = {1, 1};
+	Position corners[2] = {{0, 0}, {2, 2}};
+	SearchConstraints constraints[] = {
+		{.mustUse = &center, .numMustUse = 1},
+		{.mustUse = corners, .numMustUse = 2},
+		{.avoid = &center, .numAvoid = 1},
+		{.minLength = 4},
+		{.maxLength = 3},
+		{.requiredLetters = 1U << ('G' - 'A')},
+		{.mustUse = &corners[0], .numMustUse = 1, .avoid = &corners[1], .numAvoid = 1, .maxLength = 4},
+		{.mustUse = &center, .numMustUse = 1, .avoid = &center, .numAvoid = 1}
+	};
+
+	DynamicWordArray words = findWords(grid, trie, 7, 2);
+	for (int c = 0; c < (int)(sizeof(constraints) / sizeof(constraints[0])); c++) {
+		DynamicWordArray filtered = {.array = malloc(words.size * sizeof(WordResult)), .size = 0};
+		for (int i = 0; i < words.size; i++) {
+			if (passesConstraints(&words.array[i], &constraints[c]))
+				filtered.array[filtered.size++] = words.array[i];
+		}
+		WordResult *expected = selectBestResults(&filtered, 2);
+		WordResult *best = findBestResultsConstrained(grid, trie, 7, 2, &constraints[c]);
+		for (int i = 0; i <= 2; i++) {
+			assert(best[i].score == expected[i].score);
+			assert(best[i].word == NULL || passesConstraints(&best[i], &constraints[c]));
+		}
+		freeBestResults(best, 2);
+		freeBestResults(expected, 2);
+		free(filtered.array);
+	}
+
+	freeDynamicWordArray(&words);
+	freeGrid(grid);
+	freeTrie(trie);
+}
+
+TEST(reachability_memo) {
+	TrieNode *trie;
+	Grid *grid = makeCatDogRatFixture(&trie, 7);
+	insertWord(trie, "ZYZZYVA", 7);
+	grid->letterMultiplier[8] = 3;
+
+	// Pruning dead states must never change the results
+	for (int maxSwaps = 0; maxSwaps <= 3; maxSwaps++) {
+		setReachabilityMemo(false);
+		WordResult *expected = findBestResults(grid, trie, 7, maxSwaps);
+		setReachabilityMemo(true);
+		takeSearchStats();
+		WordResult *best = findBestResults(grid, trie, 7, maxSwaps);
+		SearchStats stats = takeSearchStats();
+
+		for (int i = 0; i <= maxSwaps; i++) {
+			assert(best[i].score == expected[i].score);
+		}
+		assert(stats.memoHits <= stats.memoLookups);
+		assert((stats.memoLookups > 0) == (maxSwaps > 0));
+		freeBestResults(best, maxSwaps);
+		freeBestResults(expected, maxSwaps);
+	}
+
+	freeGrid(grid);
+	freeTrie(trie);
+}
+
+TEST(adaptive_parallelism) {
+	TrieNode *trie;
+	Grid *grid = makeCatDogRatFixture(&trie, 7);
+
+	// A tiny search is estimated cheap and runs on the calling thread
+	takeSearchStats();
+	WordResult *best = findBestResults(grid, trie, 7, 1);
+	SearchStats stats = takeSearchStats();
+	assert(stats.estimatedCost > 0);
+	assert(stats.serialSearches == 1);
+	assert(stats.smallTeamSearches == 0 && stats.fullSearches == 0);
+	assert(best[0].word != NULL && best[0].score > 0);
+	freeBestResults(best, 1);
+
+	// The counters are reset once taken
+	stats = takeSearchStats();
+	assert(stats.serialSearches == 0 && stats.estimatedCost == 0);
+
+	freeGrid(grid);
+	freeTrie(trie);
+}
+
+TEST(pipelined_dictionary_loading) {
+	char* dict_filename = create_temp_file("cat\ncot\ndog\ngoat\ntoga\nrat\ntar\nart\ncod\nzebra\nlongerword\n");
+
+	Grid *grid = makeCatDogRatFixture(NULL, 0);
+
+	// Words longer than the limit are skipped, like in insertWord()
+	TrieNode *trie = loadDictionary(dict_filename, 5);
+	assert(trie->children & (1U << ('Z' - 'A')));
+	assert(!(trie->children & (1U << ('L' - 'A'))));
+
+	for (int swaps = 0; swaps <= 1; swaps++) {
+		WordResult *expected = findBestResults(grid, trie, 5, swaps);
+		DictionaryLoader *loader = startDictionaryLoad(dict_filename, 5);
+		WordResult *pipelined = findBestResultsWhileLoading(grid, loader, 5, swaps);
+		for (int i = 0; i <= swaps; i++) {
+			assert(pipelined[i].score == expected[i].score);
+		}
+		freeBestResults(pipelined, swaps);
+		freeBestResults(expected, swaps);
+		freeTrie(finishDictionaryLoad(loader));
+	}
+
+	freeTrie(trie);
+	freeGrid(grid);
+	unlink(dict_filename);
+	free(dict_filename);
+}
+
+TEST(dictionary_patching) {
+	TrieNode *root = createNode();
+	insertWord(root, "CAT", 5);
+	insertWord(root, "CATS", 5);
+	insertWord(root, "DOG", 5);
+
+	// Removing leaves a tombstone that compaction reclaims
+	assert(removeWord(root, "cats"));
+	assert(!removeWord(root, "cats"));
+	assert(!removeWord(root, "cow"));
+	TrieNode *cat = root->childPtrs['C' - 'A']->childPtrs['A' - 'A']->childPtrs['T' - 'A'];
+	assert(cat->children & (1U << ('S' - 'A')));
+	assert(compactTrie(root) == 1);
+	assert(cat->isWord && cat->children == 0);
+
+	char* patch_filename = create_temp_file("# curated\n+cow\n-dog\n+toolongword\n\n");
+	int added, removed;
+	assert(applyDictionaryPatch(root, patch_filename, 5, &added, &removed, NULL));
+	assert(added == 1 && removed == 1);
+	assert(root->childPtrs['C' - 'A']->childPtrs['O' - 'A']->childPtrs['W' - 'A']->isWord);
+
+	// Re-applying is a no-op, and compaction drops the removed DOG branch entirely
+	assert(applyDictionaryPatch(root, patch_filename, 5, &added, &removed, NULL));
+	assert(added == 0 && removed == 0);
+	assert(compactTrie(root) == 3);
+	assert(!(root->children & (1U << ('D' - 'A'))));
+	unlink(patch_filename);
+	free(patch_filename);
+
+	// Malformed patches are rejected without applying anything
+	patch_filename = create_temp_file("-cat\nbogus\n");
+	assert(!applyDictionaryPatch(root, patch_filename, 5, &added, &removed, NULL));
+	assert(cat->isWord);
+	unlink(patch_filename);
+	free(patch_filename);
+
+	// So are words without letters, which would otherwise mark the root as a word
+	patch_filename = create_temp_file("-cat\n+123\n");
+	assert(!applyDictionaryPatch(root, patch_filename, 5, &added, &removed, NULL));
+	assert(cat->isWord && !root->isWord && root->minWordLength > 0);
+	unlink(patch_filename);
+	free(patch_filename);
+
+	freeTrie(root);
+}
+
+TEST(batch_patch_refresh) {
+	TrieNode *trie;
+	Grid *grid = makeCatDogRatFixture(&trie, 7);
+	char* patch_filename = create_temp_file("-cod\n+cow\n-cat\n");
+	AppliedPatch applied = {0};
+	int added, removed;
+	assert(applyDictionaryPatch(trie, patch_filename, 7, &added, &removed, &applied));
+	assert(added == 1 && removed == 2 && applied.numLines == 3);
+	assert(!trie_has_word(trie, "COD") && trie_has_word(trie, "COW"));
+
+	// Dropping lines from the patch file brings the words they removed back, as a fresh load would
+	FILE* patch = fopen(patch_filename, "w");
+	fprintf(patch, "-cat\n+cow\n");
+	fclose(patch);
+	assert(revertDictionaryPatch(trie, &applied) == 1);
+	assert(applied.lines == NULL && applied.numLines == 0);
+	assert(trie_has_word(trie, "COD") && trie_has_word(trie, "CAT") && !trie_has_word(trie, "COW"));
+	assert(applyDictionaryPatch(trie, patch_filename, 7, &added, &removed, &applied));
+	assert(added == 1 && removed == 1);
+	assert(trie_has_word(trie, "COD") && !trie_has_word(trie, "CAT") && trie_has_word(trie, "COW"));
+
+	// An emptied patch file leaves exactly the unpatched words
+	patch = fopen(patch_filename, "w");
+	fclose(patch);
+	revertDictionaryPatch(trie, &applied);
+	assert(applyDictionaryPatch(trie, patch_filename, 7, &added, &removed, &applied));
+	assert(added == 0 && removed == 0 && applied.numLines == 0);
+	for (int i = 0; i < (int)(sizeof(CAT_DOG_RAT_WORDS) / sizeof(CAT_DOG_RAT_WORDS[0])); i++) {
+		assert(trie_has_word(trie, CAT_DOG_RAT_WORDS[i]));
+	}
+	assert(!trie_has_word(trie, "COW"));
+	revertDictionaryPatch(trie, &applied);
+
+	unlink(patch_filename);
+	free(patch_filename);
+	freeTrie(trie);
+	freeGrid(grid);
+}
+
+TEST(merged_dictionaries) {
+	char* official = create_temp_file("cat\ngoat\ntoga\ncod\n");
+	char* common = create_temp_file("cat\ndog\nrat\n");
+	const char* files[] = {official, common};
+	TrieNode *trie = loadDictionaries(files, 2, 7);
+
+	// Shared words are stored once, flagged with every list that contains them
+	TrieNode *cat = trie->childPtrs['C' - 'A']->childPtrs['A' - 'A']->childPtrs['T' - 'A'];
+	TrieNode *dog = trie->childPtrs['D' - 'A']->childPtrs['O' - 'A']->childPtrs['G' - 'A'];
+	assert(cat->isWord == 3);
+	assert(dog->isWord == 2);
+
+	Grid *grid = makeCatDogRatFixture(NULL, 0);
+
+	// One search gives the same best words as searching each list on its own
+	int maxSwaps = 1;
+	WordResult *results = findBestResultsPerList(grid, trie, 7, maxSwaps, 2, NULL);
+	for (int list = 0; list < 2; list++) {
+		TrieNode *single = loadDictionary(files[list], 7);
+		WordResult *expected = findBestResults(grid, single, 7, maxSwaps);
+		for (int i = 0; i <= maxSwaps; i++) {
+			assert(results[list * (maxSwaps + 1) + i].score == expected[i].score);
+		}
+		freeBestResults(expected, maxSwaps);
+		freeTrie(single);
+	}
+
+	// List names are escaped in the JSON output, so any path gives valid JSON
+	const char* names[] = {"lists/\"official\".txt", "C:\\words\tcommon.txt"};
+	char* output_filename = create_temp_file("");
+	fflush(stdout);
+	int saved_stdout = dup(STDOUT_FILENO);
+	int output_fd = open(output_filename, O_WRONLY | O_TRUNC);
+	dup2(output_fd, STDOUT_FILENO);
+	close(output_fd);
+	outputListResults(results, 2, names, maxSwaps, grid, OUTPUT_JSON);
+	fflush(stdout);
+	dup2(saved_stdout, STDOUT_FILENO);
+	close(saved_stdout);
+
+	char output[4096] = {0};
+	FILE* output_file = fopen(output_filename, "r");
+	assert(fread(output, 1, sizeof(output) - 1, output_file) > 0);
+	fclose(output_file);
+	assert(strstr(output, "\"dictionary\": \"lists/\\\"official\\\".txt\",\n") != NULL);
+	assert(strstr(output, "\"dictionary\": \"C:\\\\words\\u0009common.txt\",\n") != NULL);
+	unlink(output_filename);
+	free(output_filename);
+	freeBestResults(results, 2 * (maxSwaps + 1) - 1);
+
+	// Patches only change the first list
+	assert(removeWord(trie, "cat"));
+	assert(cat->isWord == 2);
+
+	freeGrid(grid);
+	freeTrie(trie);
+	unlink(official);
+	unlink(common);
+	free(official);
+	free(common);
+}
+
+TEST(word_length_annotations) {
+	char* dict_filename = create_temp_file("cat\r\ncats\r\ncatalog\r\ngoat\r\ntoga\r\ndog\r\ncodgart\r\n");
+	TrieNode *full = loadDictionary(dict_filename, DICTIONARY_MAX_WORD_LENGTH);
+
+	// Each node knows the shortest and longest word below it, counted from the root
+	TrieNode *ca = full->childPtrs['C' - 'A']->childPtrs['A' - 'A'];
+	assert(ca->minWordLength == 3 && ca->maxWordLength == 7);
+	assert(full->minWordLength == 3 && full->maxWordLength == 7);
+
+	// Compaction tightens the bounds left behind by removals
+	assert(removeWord(full, "catalog"));
+	assert(ca->maxWordLength == 7);
+	compactTrie(full);
+	assert(ca->maxWordLength == 4);
+	insertWord(full, "catalog", DICTIONARY_MAX_WORD_LENGTH);
+
+	// The longest word keeps a real bound, distinct from the "no word below" marker
+	TrieNode *longest = createNode();
+	char word[DICTIONARY_MAX_WORD_LENGTH + 2];
+	memset(word, 'A', DICTIONARY_MAX_WORD_LENGTH + 1);
+	word[DICTIONARY_MAX_WORD_LENGTH + 1] = '\0';
+	insertWord(longest, word, DICTIONARY_MAX_WORD_LENGTH + 1);
+	assert(longest->minWordLength == DICTIONARY_MAX_WORD_LENGTH && longest->minWordLength != UINT8_MAX);
+	assert(longest->maxWordLength == DICTIONARY_MAX_WORD_LENGTH);
+	freeTrie(longest);
+
+	Grid *grid = makeCatDogRatFixture(NULL, 0);
+
+	// Searching the full Trie with a limit finds what a Trie loaded with that limit finds
+	for (int limit = 3; limit <= 7; limit++) {
+		TrieNode *limited = loadDictionary(dict_filename, limit);
+		for (int maxSwaps = 0; maxSwaps <= 2; maxSwaps++) {
+			WordResult *expected = findBestResults(grid, limited, limit, maxSwaps);
+			WordResult *best = findBestResults(grid, full, limit, maxSwaps);
+			for (int i = 0; i <= maxSwaps; i++) {
+				assert(best[i].score == expected[i].score);
+				assert(best[i].length <= limit);
+			}
+			freeBestResults(best, maxSwaps);
+			freeBestResults(expected, maxSwaps);
+		}
+		freeTrie(limited);
+	}
+
+	freeGrid(grid);
+	freeTrie(full);
+	unlink(dict_filename);
+	free(dict_filename);
+}
+
+TEST(crlf_word_lengths) {
+	// Words exactly as long as the limit, without a final line ending, so the last one ends the buffer
+	char* dict_filename = create_temp_file("goat\r\ntoga\r\ncat\r\ncodgart\r\ntart");
+	TrieNode *trie = loadDictionary(dict_filename, 4);
+
+	// The copy of each word stops before the CR, so it fits the buffer sized for the limit
+	assert(trie_has_word(trie, "goat"));
+	assert(trie_has_word(trie, "toga"));
+	assert(trie_has_word(trie, "cat"));
+	assert(trie_has_word(trie, "tart"));
+	assert(!trie_has_word(trie, "codgart"));
+	assert(trie->maxWordLength == 4);
+
+	freeTrie(trie);
+	unlink(dict_filename);
+	free(dict_filename);
+}
+
+TEST(perf_counters) {
+	// Works whether or not the host provides the events, reporting null for missing ones
+	PerfCounters *counters = openPerfCounters();
+	beginPerfPhase(counters);
+	volatile unsigned long sum = 0;
+	for (unsigned long i = 0; i < 1000000; i++) {
+		sum += i;
+	}
+	PerfSample sample = endPerfPhase(counters);
+	assert(sample.wallMs >= 0);
+	assert(sample.numThreads >= 1);
+	if (sample.available[PERF_INSTRUCTIONS])
+		assert(sample.totals[PERF_INSTRUCTIONS] > 0);
+
+	FILE *out = tmpfile();
+	printPerfSample(out, "test", &sample);
+	rewind(out);
+	char line[4096];
+	assert(fgets(line, sizeof(line), out) != NULL);
+	const char *prefix = "{\"phase\": \"test\", \"wall_ms\": ";
+	assert(strncmp(line, prefix, strlen(prefix)) == 0);
+	assert(strstr(line, sample.available[PERF_CYCLES] ? "\"cycles\": " : "\"cycles\": null") != NULL);
+	assert(line[strlen(line) - 2] == '}');
+	fclose(out);
+
+	closePerfCounters(counters);
+}
+
+TEST(binary_results) {
+	char* dict_filename = create_temp_file("cat\ngoat\ntoga\ndog\n");
+	TrieNode *trie = loadDictionary(dict_filename, 7);
+	Grid *grid = makeCatDogRatFixture(NULL, 0);
+
+	// Two result sets back to back, as a batch run writes them
+	int maxSwaps = 2;
+	WordResult *results = findBestResults(grid, trie, 7, maxSwaps);
+	FILE *out = tmpfile();
+	writeBinaryResults(results, 1, maxSwaps, grid, out);
+	writeBinaryResults(results, 1, maxSwaps, grid, out);
+	fflush(out);
+	long size = ftell(out);
+	void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(out), 0);
+	assert(data != MAP_FAILED);
+
+	const BinaryResultsHeader *header = binaryResultsHeader(data, size);
+	assert(header != NULL && header->totalSize % 8 == 0);
+	assert(header->numRecords == (uint32_t)maxSwaps + 1 && header->gridSize == 3);
+	size_t remaining = size;
+	for (int set = 0; set < 2; set++) {
+		for (int i = 0; i <= maxSwaps; i++) {
+			const BinaryResultRecord *record = binaryResultRecord(header, i);
+			assert(record->swaps == i && record->score == results[i].score);
+			assert(strcmp(binaryResultWord(header, record), results[i].word ? results[i].word : "") == 0);
+			for (int j = 0; j < record->length; j++) {
+				assert(record->cells[j] == results[i].positions[j].row * 3 + results[i].positions[j].col);
+			}
+			for (int j = 0; j < record->numSwaps; j++) {
+				assert(binaryResultSwapCells(header, record)[j] ==
+					   results[i].swapPositions[j].row * 3 + results[i].swapPositions[j].col);
+			}
+		}
+		const BinaryResultsHeader *next = nextBinaryResults(header, remaining);
+		assert((next != NULL) == (set == 0));
+		remaining -= header->totalSize;
+		header = next;
+	}
+	assert(remaining == 0);
+
+	// Foreign data is rejected, and so are sets that would not advance or run past the string table
+	assert(binaryResultsHeader("SCRC", 4) == NULL);
+	BinaryResultsHeader *copy = malloc(size);
+	memcpy(copy, data, size);
+	copy->totalSize = 0;
+	assert(binaryResultsHeader(copy, size) == NULL);
+	memcpy(copy, data, size);
+	copy->headerSize = 0;
+	assert(binaryResultsHeader(copy, size) == NULL);
+	memcpy(copy, data, size);
+	BinaryResultRecord *record = (BinaryResultRecord *)binaryResultRecord(copy, maxSwaps);
+	record->wordOffset = copy->stringsSize;
+	assert(binaryResultsHeader(copy, size) == copy && binaryResultWord(copy, record) == NULL);
+	free(copy);
+
+	munmap(data, size);
+	fclose(out);
+	freeBestResults(results, maxSwaps);
+	freeGrid(grid);
+	freeTrie(trie);
+	unlink(dict_filename);
+	free(dict_filename);
+}
+
+TEST(required_letters) {
+	char* dict_filename = create_temp_file("quiz\nquit\nquite\nzoo\n");
+	TrieNode *trie = loadDictionary(dict_filename, 7);
+
+	// Each node knows the letters every word below it still has to spell
+	TrieNode *q = trie->childPtrs['Q' - 'A'];
+	TrieNode *quit = q->childPtrs['U' - 'A']->childPtrs['I' - 'A']->childPtrs['T' - 'A'];
+	uint32_t ui = (1U << ('U' - 'A')) | (1U << ('I' - 'A'));
+	assert(q->requiredLetters == ui);
+	assert(quit->requiredLetters == 0);
+	assert(quit->childPtrs['E' - 'A']->requiredLetters == 0);
+
+	// Compaction tightens the masks left behind by removals
+	assert(removeWord(trie, "quiz"));
+	assert(q->requiredLetters == ui);
+	compactTrie(trie);
+	assert(q->requiredLetters == (ui | (1U << ('T' - 'A'))));
+	insertWord(trie, "quiz", 7);
+	assert(q->requiredLetters == ui);
+
+	// The board lacks a U, so words starting with Q need a swap
+	Grid *grid = createGrid(2);
+	char gridLetters[4] = {'Q', 'X', 'I', 'Z'};
+	memcpy(grid->letters, gridLetters, 4 * sizeof(char));
+	WordResult *results = findBestResults(grid, trie, 7, 1);
+	assert(results[0].word == NULL);
+	assert(results[1].word != NULL && strcmp(results[1].word, "QUIZ") == 0);
+	freeBestResults(results, 1);
+
+	freeGrid(grid);
+	freeTrie(trie);
+	unlink(dict_filename);
+	free(dict_filename);
+}
+
+TEST(iterative_search) {
+	TrieNode *trie = createNode();
+	insertWord(trie, "ABCFEDGHI", 9);
+	insertWord(trie, "AB", 9);
+
+	// The long word snakes through every cell, so the frame stack is as deep as the grid is large
+	Grid *grid = createGrid(3);
+	char gridLetters[9] = {'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I'};
+	memcpy(grid->letters, gridLetters, 9 * sizeof(char));
+	WordResult *results = findBestResults(grid, trie, 9, 0);
+	assert(results[0].word != NULL && strcmp(results[0].word, "ABCFEDGHI") == 0);
+	assert(results[0].positions[3].row == 1 && results[0].positions[3].col == 2);
+	freeBestResults(results, 0);
+
+	// The thread's scratch is reused, and the cells a constrained search avoided are free again
+	Position corner = {2, 2};
+	SearchConstraints avoid = {.avoid = &corner, .numAvoid = 1};
+	results = findBestResultsConstrained(grid, trie, 9, 0, &avoid);
+	assert(results[0].word != NULL && strcmp(results[0].word, "AB") == 0);
+	freeBestResults(results, 0);
+	results = findBestResults(grid, trie, 9, 0);
+	assert(results[0].word != NULL && strcmp(results[0].word, "ABCFEDGHI") == 0);
+	freeBestResults(results, 0);
+
+	// A search of another shape gets a scratch of its own
+	results = findBestResults(grid, trie, 8, 0);
+	assert(results[0].word != NULL && strcmp(results[0].word, "AB") == 0);
+	freeBestResults(results, 0);
+	DynamicWordArray words = findWords(grid, trie, 9, 1);
+	int found = 0;
+	for (int i = 0; i < words.size; i++)
+		found += strcmp(words.array[i].word, "ABCFEDGHI") == 0;
+	assert(found == 1);
+	freeDynamicWordArray(&words);
+
+	// Searches after the scratch spaces are released allocate new ones
+	freeThreadScratch();
+	results = findBestResults(grid, trie, 9, 0);
+	assert(results[0].word != NULL && strcmp(results[0].word, "ABCFEDGHI") == 0);
+	freeBestResults(results, 0);
+	freeThreadScratch();
+
+	freeGrid(grid);
+	freeTrie(trie);
+}
+
 int main() {
 	RUN_TEST(grid_creation);
 	RUN_TEST(grid_loading);
@@ -407,6 +1205,24 @@ int main() {
 	RUN_TEST(word_finding);
 	RUN_TEST(score_calculation);
 	RUN_TEST(specific_word_finding);
+	RUN_TEST(result_cache);
+	RUN_TEST(best_words_and_planning);
+	RUN_TEST(large_board_visited);
+	RUN_TEST(frontier_engine);
+	RUN_TEST(trie_replication);
+	RUN_TEST(search_constraints);
+	RUN_TEST(reachability_memo);
+	RUN_TEST(adaptive_parallelism);
+	RUN_TEST(pipelined_dictionary_loading);
+	RUN_TEST(dictionary_patching);
+	RUN_TEST(batch_patch_refresh);
+	RUN_TEST(merged_dictionaries);
+	RUN_TEST(word_length_annotations);
+	RUN_TEST(crlf_word_lengths);
+	RUN_TEST(perf_counters);
+	RUN_TEST(binary_results);
+	RUN_TEST(required_letters);
+	RUN_TEST(iterative_search);
 	printf("All tests passed!\n");
 	return 0;
 }
\ No newline at end of file
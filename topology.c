@@ -0,0 +1,165 @@
+#include <omp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "topology.h"
+
+#define NODE_SYSFS_DIR "/sys/devices/system/node"
+
+// Node index (into the replicas) the calling thread was pinned to, or -1
+static __thread int threadNode = -1;
+
+typedef struct {
+	const TrieNode *source;
+	const cpu_set_t *cpus;
+	TrieNode *copy;
+	bool started;
+} ReplicaJob;
+
+// Parses a sysfs list such as "0-3,8-11" into a set
+static bool readSysfsList(const char *path, cpu_set_t *set) {
+	FILE *file = fopen(path, "r");
+	if (!file)
+		return false;
+	char buffer[4096];
+	bool ok = fgets(buffer, sizeof(buffer), file) != NULL;
+	fclose(file);
+	if (!ok)
+		return false;
+
+	CPU_ZERO(set);
+	char *p = buffer;
+	while (*p != '\0' && *p != '\n') {
+		char *end;
+		long first = strtol(p, &end, 10);
+		if (end == p)
+			return false;
+		long last = first;
+		if (*end == '-') {
+			p = end + 1;
+			last = strtol(p, &end, 10);
+			if (end == p)
+				return false;
+		}
+		for (long i = first; i <= last && i < CPU_SETSIZE; i++) {
+			CPU_SET(i, set);
+		}
+		p = (*end == ',') ? end + 1 : end;
+	}
+	return true;
+}
+
+static void* buildReplica(void *arg) {
+	ReplicaJob *job = arg;
+	sched_setaffinity(0, sizeof(cpu_set_t), job->cpus);
+	job->copy = copyTrie(job->source);
+	return NULL;
+}
+
+static void discoverNodes(TrieReplicas *replicas) {
+	cpu_set_t allowed;
+	if (sched_getaffinity(0, sizeof(cpu_set_t), &allowed) == -1) {
+		CPU_ZERO(&allowed);
+		CPU_SET(0, &allowed);
+	}
+
+	cpu_set_t nodes;
+	int maxNodes = readSysfsList(NODE_SYSFS_DIR "/online", &nodes) ? CPU_COUNT(&nodes) : 0;
+	replicas->nodeCpus = malloc((maxNodes > 0 ? maxNodes : 1) * sizeof(cpu_set_t));
+	if (!replicas->nodeCpus) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+
+	replicas->numNodes = 0;
+	for (int node = 0; node < CPU_SETSIZE && replicas->numNodes < maxNodes; node++) {
+		if (!CPU_ISSET(node, &nodes))
+			continue;
+		char path[128];
+		snprintf(path, sizeof(path), NODE_SYSFS_DIR "/node%d/cpulist", node);
+		cpu_set_t *cpus = &replicas->nodeCpus[replicas->numNodes];
+		if (!readSysfsList(path, cpus))
+			continue;
+		CPU_AND(cpus, cpus, &allowed);
+		if (CPU_COUNT(cpus) > 0)
+			replicas->numNodes++;
+	}
+
+	// No NUMA information: treat the whole machine as one node
+	if (replicas->numNodes == 0) {
+		replicas->nodeCpus[0] = allowed;
+		replicas->numNodes = 1;
+	}
+}
+
+TrieReplicas* createTrieReplicas(TrieNode *trie, bool replicate) {
+	TrieReplicas *replicas = calloc(1, sizeof(TrieReplicas));
+	if (!replicas) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	discoverNodes(replicas);
+
+	replicas->roots = malloc(replicas->numNodes * sizeof(TrieNode *));
+	ReplicaJob *jobs = calloc(replicas->numNodes, sizeof(ReplicaJob));
+	pthread_t *threads = malloc(replicas->numNodes * sizeof(pthread_t));
+	if (!replicas->roots || !jobs || !threads) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+
+	replicas->replicated = replicate && replicas->numNodes > 1;
+	for (int i = 0; i < replicas->numNodes; i++) {
+		replicas->roots[i] = trie;
+		jobs[i] = (ReplicaJob){trie, &replicas->nodeCpus[i], NULL, false};
+		if (replicas->replicated) {
+			jobs[i].started = pthread_create(&threads[i], NULL, buildReplica, &jobs[i]) == 0;
+			// Without a thread the copy is built here, and placed wherever this thread runs
+			if (!jobs[i].started)
+				buildReplica(&jobs[i]);
+		}
+	}
+	if (replicas->replicated) {
+		for (int i = 0; i < replicas->numNodes; i++) {
+			if (jobs[i].started)
+				pthread_join(threads[i], NULL);
+			replicas->roots[i] = jobs[i].copy;
+		}
+	}
+
+	free(threads);
+	free(jobs);
+	return replicas;
+}
+
+void pinSearchThreads(const TrieReplicas *replicas) {
+	#pragma omp parallel
+	{
+		int node = omp_get_thread_num() * replicas->numNodes / omp_get_num_threads();
+		if (sched_setaffinity(0, sizeof(cpu_set_t), &replicas->nodeCpus[node]) == 0)
+			threadNode = node;
+	}
+}
+
+TrieNode* localReplica(const TrieReplicas *replicas) {
+	if (threadNode >= 0 && threadNode < replicas->numNodes)
+		return replicas->roots[threadNode];
+
+	int cpu = sched_getcpu();
+	for (int i = 0; cpu >= 0 && i < replicas->numNodes; i++) {
+		if (CPU_ISSET(cpu, &replicas->nodeCpus[i]))
+			return replicas->roots[i];
+	}
+	return replicas->roots[0];
+}
+
+void freeTrieReplicas(TrieReplicas *replicas) {
+	if (replicas->replicated) {
+		for (int i = 0; i < replicas->numNodes; i++) {
+			freeTrie(replicas->roots[i]);
+		}
+	}
+	free(replicas->roots);
+	free(replicas->nodeCpus);
+	free(replicas);
+}
@@ -0,0 +1,56 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <sched.h>
+#include <stdbool.h>
+#include "trie.h"
+
+// One Trie per NUMA node, plus the CPUs this process may use on each node
+typedef struct {
+	int numNodes;
+	TrieNode **roots;
+	cpu_set_t *nodeCpus;
+	bool replicated;    // Whether roots are copies owned by the replicas
+} TrieReplicas;
+
+/**
+ * Discovers the NUMA nodes from sysfs and places one copy of the Trie on each.
+ *
+ * Each copy is built by a thread pinned to its node, so first-touch placement
+ * puts its pages in that node's memory. Nodes without usable CPUs are skipped.
+ * On a single-node machine, without sysfs, or when replicate is false, every
+ * node shares the original Trie instead.
+ *
+ * @param trie The Trie to replicate (still owned by the caller).
+ * @param replicate Whether to make per-node copies.
+ * @return The replicas, to be released with freeTrieReplicas().
+ */
+TrieReplicas* createTrieReplicas(TrieNode *trie, bool replicate);
+
+/**
+ * Pins each OpenMP thread to the CPUs of one NUMA node.
+ *
+ * Threads are spread over the nodes in contiguous blocks, so a team of T threads
+ * on N nodes places about T / N threads on each node. The calling thread is part
+ * of the team and stays pinned afterwards.
+ *
+ * @param replicas The replicas describing the nodes.
+ */
+void pinSearchThreads(const TrieReplicas *replicas);
+
+/**
+ * Returns the Trie replica local to the calling thread.
+ *
+ * @param replicas The replicas.
+ * @return The replica of the node the thread was pinned to, or else of the node it runs on.
+ */
+TrieNode* localReplica(const TrieReplicas *replicas);
+
+/**
+ * Frees the replicas and the per-node copies, but not the original Trie.
+ *
+ * @param replicas The replicas to free.
+ */
+void freeTrieReplicas(TrieReplicas *replicas);
+
+#endif // TOPOLOGY_H
@@ -2,6 +2,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "trie.h"
 
 TrieNode* createNode() {
@@ -10,16 +15,49 @@ TrieNode* createNode() {
 		fprintf(stderr, "Memory allocation failed\n");
 		exit(1);
 	}
+	node->requiredLetters = ALL_LETTERS;
+	node->minWordLength = UINT8_MAX;
 	return node;
 }
 
+static inline void includeWordLengths(TrieNode *node, int minWordLength, int maxWordLength) {
+	if (minWordLength < node->minWordLength)
+		node->minWordLength = minWordLength;
+	if (maxWordLength > node->maxWordLength)
+		node->maxWordLength = maxWordLength;
+}
+
 void insertWord(TrieNode *root, const char *word, int maxWordLength) {
+	insertWordInList(root, word, maxWordLength, 0);
+}
+
+void insertWordInList(TrieNode *root, const char *word, int maxWordLength, int list) {
+	if (maxWordLength > DICTIONARY_MAX_WORD_LENGTH)
+		maxWordLength = DICTIONARY_MAX_WORD_LENGTH;
+
+	// Counts of the letters after the current node, and the mask of those left
+	int length = 0;
+	int letterCounts[26] = {0};
+	uint32_t lettersAfter = 0;
+	for (int i = 0; word[i] && i < maxWordLength; i++) {
+		char c = toupper(word[i]);
+		if (c < 'A' || c > 'Z')
+			continue;
+		length++;
+		letterCounts[c - 'A']++;
+		lettersAfter |= 1U << (c - 'A');
+	}
+
 	TrieNode *node = root;
+	includeWordLengths(node, length, length);
+	node->requiredLetters &= lettersAfter;
 	for (int i = 0; word[i] && i < maxWordLength; i++) {
 		char c = toupper(word[i]);
 		if (c < 'A' || c > 'Z')
 			continue;
 		int index = c - 'A';
+		if (--letterCounts[index] == 0)
+			lettersAfter &= ~(1U << index);
 		if (!(node->children & (1U << index))) {
 			node->children |= (1U << index);
 			if (!node->childPtrs) {
@@ -28,35 +66,454 @@ void insertWord(TrieNode *root, const char *word, int maxWordLength) {
 			node->childPtrs[index] = createNode();
 		}
 		node = node->childPtrs[index];
+		includeWordLengths(node, length, length);
+		node->requiredLetters &= lettersAfter;
 	}
-	node->isWord = true;
+	node->isWord |= 1U << list;
 }
 
-TrieNode* loadDictionary(const char *filePath, int maxWordLength) {
+TrieNode* copyTrie(const TrieNode *root) {
+	TrieNode *copy = createNode();
+	copy->isWord = root->isWord;
+	copy->requiredLetters = root->requiredLetters;
+	copy->minWordLength = root->minWordLength;
+	copy->maxWordLength = root->maxWordLength;
+	copy->children = root->children;
+	if (root->children) {
+		copy->childPtrs = calloc(26, sizeof(TrieNode*));
+		if (!copy->childPtrs) {
+			fprintf(stderr, "Memory allocation failed\n");
+			exit(1);
+		}
+		for (uint32_t children = root->children; children; children &= (children - 1)) {
+			int i = __builtin_ctz(children);
+			copy->childPtrs[i] = copyTrie(root->childPtrs[i]);
+		}
+	}
+	return copy;
+}
+
+static bool containsWord(const TrieNode *root, const char *word) {
+	const TrieNode *node = root;
+	for (int i = 0; word[i]; i++) {
+		char c = toupper(word[i]);
+		if (c < 'A' || c > 'Z')
+			continue;
+		int index = c - 'A';
+		if (!(node->children & (1U << index)))
+			return false;
+		node = node->childPtrs[index];
+	}
+	return node->isWord & 1;
+}
+
+bool removeWord(TrieNode *root, const char *word) {
+	TrieNode *node = root;
+	for (int i = 0; word[i]; i++) {
+		char c = toupper(word[i]);
+		if (c < 'A' || c > 'Z')
+			continue;
+		int index = c - 'A';
+		if (!(node->children & (1U << index)))
+			return false;
+		node = node->childPtrs[index];
+	}
+	bool wasWord = node->isWord & 1;
+	node->isWord &= ~1U;
+	return wasWord;
+}
+
+static bool compactNode(TrieNode *node, int depth, int *freed) {
+	node->minWordLength = node->isWord ? depth : UINT8_MAX;
+	node->maxWordLength = node->isWord ? depth : 0;
+	node->requiredLetters = node->isWord ? 0 : ALL_LETTERS;
+	unsigned int children = node->children;
+	while (children) {
+		int index = __builtin_ctz(children);
+		children &= (children - 1);
+		TrieNode *child = node->childPtrs[index];
+		if (!compactNode(child, depth + 1, freed)) {
+			freeTrie(child);
+			(*freed)++;
+			node->childPtrs[index] = NULL;
+			node->children &= ~(1U << index);
+		} else {
+			includeWordLengths(node, child->minWordLength, child->maxWordLength);
+			node->requiredLetters &= (1U << index) | child->requiredLetters;
+		}
+	}
+
+	if (!node->children && node->childPtrs) {
+		free(node->childPtrs);
+		node->childPtrs = NULL;
+	}
+	return node->isWord || node->children;
+}
+
+int compactTrie(TrieNode *root) {
+	int freed = 0;
+	compactNode(root, 0, &freed);
+	return freed;
+}
+
+// Index of the first letter of a line, or -1 if it has none, which the dictionary skips like a blank line
+static int firstLetter(const char *line, size_t length) {
+	for (size_t i = 0; i < length; i++) {
+		char c = toupper(line[i]);
+		if (c >= 'A' && c <= 'Z')
+			return c - 'A';
+	}
+	return -1;
+}
+
+bool applyDictionaryPatch(TrieNode *root, const char *filePath, int maxWordLength, int *added, int *removed,
+						  AppliedPatch *applied) {
 	FILE *file = fopen(filePath, "r");
 	if (!file) {
-		perror("Error opening dictionary file");
-		exit(1);
+		perror("Error opening dictionary patch file");
+		return false;
 	}
 
-	TrieNode *root = createNode();
-	char *word = NULL;
+	char **lines = NULL;
+	int numLines = 0;
+	int capacity = 0;
+	bool valid = true;
+	char *line = NULL;
 	size_t len = 0;
+	int lineNumber = 0;
 
-	while (getline(&word, &len, file) != -1) {
-		size_t wordLen = strlen(word);
-		if (wordLen > 0 && word[wordLen - 1] == '\n') {
-			word[wordLen - 1] = '\0';
-			wordLen--;
+	while (getline(&line, &len, file) != -1) {
+		lineNumber++;
+		line[strcspn(line, "\r\n")] = '\0';
+		if (line[0] == '\0' || line[0] == '#')
+			continue;
+		if ((line[0] != '+' && line[0] != '-') || firstLetter(line + 1, strlen(line + 1)) < 0) {
+			fprintf(stderr, "Error: Invalid dictionary patch line %d: %s\n", lineNumber, line);
+			valid = false;
+			break;
 		}
 
-		if (wordLen <= (size_t)maxWordLength) {
+		if (numLines == capacity) {
+			capacity = capacity ? capacity * 2 : 64;
+			lines = realloc(lines, capacity * sizeof(char *));
+			if (!lines) {
+				fprintf(stderr, "Memory reallocation failed\n");
+				exit(1);
+			}
+		}
+		lines[numLines++] = strdup(line);
+	}
+	free(line);
+	fclose(file);
+
+	*added = 0;
+	*removed = 0;
+	int numApplied = 0;
+	for (int i = 0; i < numLines; i++) {
+		const char *word = lines[i] + 1;
+		bool changed = false;
+		if (valid && lines[i][0] == '+' && strlen(word) <= (size_t)maxWordLength && !containsWord(root, word)) {
 			insertWord(root, word, maxWordLength);
+			(*added)++;
+			changed = true;
+		} else if (valid && lines[i][0] == '-' && removeWord(root, word)) {
+			(*removed)++;
+			changed = true;
 		}
+
+		// The changed lines are kept in place at the front of the array
+		if (changed && applied != NULL)
+			lines[numApplied++] = lines[i];
+		else
+			free(lines[i]);
+	}
+	if (applied != NULL) {
+		applied->lines = lines;
+		applied->numLines = numApplied;
+	} else {
+		free(lines);
+	}
+	return valid;
+}
+
+int revertDictionaryPatch(TrieNode *root, AppliedPatch *applied) {
+	int removed = 0;
+	for (int i = applied->numLines - 1; i >= 0; i--) {
+		const char *word = applied->lines[i] + 1;
+		if (applied->lines[i][0] == '+' && removeWord(root, word))
+			removed++;
+		else if (applied->lines[i][0] == '-')
+			insertWord(root, word, DICTIONARY_MAX_WORD_LENGTH);
+		free(applied->lines[i]);
+	}
+	free(applied->lines);
+	applied->lines = NULL;
+	applied->numLines = 0;
+	return removed;
+}
+
+#define MAX_LOADER_THREADS 8
+
+struct DictionaryLoader {
+	TrieNode *root;
+	char *data;
+	size_t size;
+	int maxWordLength;
+	uint32_t *lineStarts[26];       // Offsets of the words indexed by first letter
+	uint32_t *lineStartsBlock;      // Backing storage of lineStarts, kept in one block off the trie's heap
+	int lineCounts[26];
+	pthread_t threads[MAX_LOADER_THREADS];
+	int numThreads;
+	pthread_mutex_t lock;
+	pthread_cond_t letterReady;
+	uint32_t pendingMask;           // Letters not yet claimed by a thread
+	uint32_t priorityMask;
+	uint32_t readyMask;
+};
+
+// The length check counts every character before the line ending (so a CRLF line counts like an LF one),
+// which makes the limit match the search's depth limit on plain word lists
+static void forEachDictionaryWord(DictionaryLoader *loader, void (*visit)(DictionaryLoader *, int, uint32_t)) {
+	size_t pos = 0;
+	while (pos < loader->size) {
+		char *newline = memchr(loader->data + pos, '\n', loader->size - pos);
+		size_t end = newline ? (size_t)(newline - loader->data) : loader->size;
+		size_t length = end - pos;
+		if (length > 0 && loader->data[end - 1] == '\r')
+			length--;
+		int letter = firstLetter(loader->data + pos, end - pos);
+		if (length <= (size_t)loader->maxWordLength && letter >= 0)
+			visit(loader, letter, pos);
+		pos = end + 1;
+	}
+}
+
+static void countWord(DictionaryLoader *loader, int letter, uint32_t offset) {
+	(void)offset;
+	loader->lineCounts[letter]++;
+}
+
+static void indexWord(DictionaryLoader *loader, int letter, uint32_t offset) {
+	loader->lineStarts[letter][loader->lineCounts[letter]++] = offset;
+}
+
+static void indexDictionary(DictionaryLoader *loader) {
+	forEachDictionaryWord(loader, countWord);
+
+	size_t numWords = 0;
+	for (int i = 0; i < 26; i++) {
+		numWords += loader->lineCounts[i];
+	}
+	loader->lineStartsBlock = malloc((numWords + 1) * sizeof(uint32_t));
+	if (!loader->lineStartsBlock) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+
+	size_t offset = 0;
+	for (int i = 0; i < 26; i++) {
+		loader->lineStarts[i] = loader->lineStartsBlock + offset;
+		offset += loader->lineCounts[i];
+		loader->lineCounts[i] = 0;
+	}
+	forEachDictionaryWord(loader, indexWord);
+}
+
+static TrieNode* buildSubtrie(DictionaryLoader *loader, int letter) {
+	TrieNode *shell = createNode();
+	char *word = malloc(loader->maxWordLength + 1);
+
+	for (int i = 0; i < loader->lineCounts[letter]; i++) {
+		const char *line = loader->data + loader->lineStarts[letter][i];
+		const char *newline = memchr(line, '\n', loader->data + loader->size - line);
+		size_t length = newline ? (size_t)(newline - line) : (size_t)(loader->data + loader->size - line);
+		if (length > 0 && line[length - 1] == '\r')
+			length--;
+		memcpy(word, line, length);
+		word[length] = '\0';
+		insertWord(shell, word, loader->maxWordLength);
 	}
 
+	TrieNode *subtrie = NULL;
+	if (shell->children & (1U << letter)) {
+		subtrie = shell->childPtrs[letter];
+	}
+	free(shell->childPtrs);
+	free(shell);
 	free(word);
-	fclose(file);
+	return subtrie;
+}
+
+// Claims the next pending letter (priority letters first) and publishes its subtrie
+static bool buildNextLetter(DictionaryLoader *loader) {
+	pthread_mutex_lock(&loader->lock);
+	uint32_t candidates = loader->pendingMask & loader->priorityMask;
+	if (!candidates)
+		candidates = loader->pendingMask;
+	if (!candidates) {
+		pthread_mutex_unlock(&loader->lock);
+		return false;
+	}
+	int letter = __builtin_ctz(candidates);
+	loader->pendingMask &= ~(1U << letter);
+	pthread_mutex_unlock(&loader->lock);
+
+	TrieNode *subtrie = buildSubtrie(loader, letter);
+
+	pthread_mutex_lock(&loader->lock);
+	if (subtrie) {
+		loader->root->childPtrs[letter] = subtrie;
+		loader->root->children |= (1U << letter);
+		includeWordLengths(loader->root, subtrie->minWordLength, subtrie->maxWordLength);
+		loader->root->requiredLetters &= (1U << letter) | subtrie->requiredLetters;
+	}
+	loader->readyMask |= (1U << letter);
+	pthread_cond_broadcast(&loader->letterReady);
+	pthread_mutex_unlock(&loader->lock);
+	return true;
+}
+
+static void* loaderThread(void *arg) {
+	DictionaryLoader *loader = arg;
+	while (buildNextLetter(loader));
+	return NULL;
+}
+
+DictionaryLoader* startDictionaryLoad(const char *filePath, int maxWordLength) {
+	int fd = open(filePath, O_RDONLY);
+	if (fd == -1) {
+		perror("Error opening dictionary file");
+		exit(1);
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == -1) {
+		perror("Error reading dictionary file");
+		exit(1);
+	}
+
+	DictionaryLoader *loader = calloc(1, sizeof(DictionaryLoader));
+	if (!loader) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	loader->root = createNode();
+	loader->root->childPtrs = calloc(26, sizeof(TrieNode*));
+	loader->size = st.st_size;
+	loader->maxWordLength = maxWordLength;
+	if (loader->size > 0) {
+		loader->data = mmap(NULL, loader->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (loader->data == MAP_FAILED) {
+			perror("Error mapping dictionary file");
+			exit(1);
+		}
+	}
+	close(fd);
+
+	indexDictionary(loader);
+
+	pthread_mutex_init(&loader->lock, NULL);
+	pthread_cond_init(&loader->letterReady, NULL);
+	loader->pendingMask = ALL_LETTERS;
+
+	// With a single CPU there is nothing to overlap with, so the caller builds subtries on demand instead
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	loader->numThreads = cpus <= 1 ? 0 : (cpus > MAX_LOADER_THREADS ? MAX_LOADER_THREADS : cpus);
+	for (int i = 0; i < loader->numThreads; i++) {
+		if (pthread_create(&loader->threads[i], NULL, loaderThread, loader) != 0) {
+			fprintf(stderr, "Failed to start dictionary loader thread\n");
+			exit(1);
+		}
+	}
+
+	return loader;
+}
+
+void prioritizeLetters(DictionaryLoader *loader, uint32_t letterMask) {
+	pthread_mutex_lock(&loader->lock);
+	loader->priorityMask = letterMask;
+	pthread_mutex_unlock(&loader->lock);
+}
+
+uint32_t waitForLetters(DictionaryLoader *loader, uint32_t knownMask, uint32_t *readyChildren) {
+	if (loader->numThreads == 0)
+		buildNextLetter(loader);
+
+	pthread_mutex_lock(&loader->lock);
+	while ((loader->readyMask & ~knownMask) == 0 && loader->readyMask != ALL_LETTERS) {
+		pthread_cond_wait(&loader->letterReady, &loader->lock);
+	}
+	uint32_t readyMask = loader->readyMask;
+	*readyChildren = loader->root->children & readyMask;
+	pthread_mutex_unlock(&loader->lock);
+	return readyMask;
+}
+
+TrieNode* dictionaryRoot(DictionaryLoader *loader) {
+	return loader->root;
+}
+
+TrieNode* finishDictionaryLoad(DictionaryLoader *loader) {
+	for (int i = 0; i < loader->numThreads; i++) {
+		pthread_join(loader->threads[i], NULL);
+	}
+	while (buildNextLetter(loader));
+
+	TrieNode *root = loader->root;
+	free(loader->lineStartsBlock);
+	if (loader->size > 0)
+		munmap(loader->data, loader->size);
+	pthread_mutex_destroy(&loader->lock);
+	pthread_cond_destroy(&loader->letterReady);
+	free(loader);
+	return root;
+}
+
+TrieNode* loadDictionary(const char *filePath, int maxWordLength) {
+	return finishDictionaryLoad(startDictionaryLoad(filePath, maxWordLength));
+}
+
+// Moves every word of a freshly loaded Trie from the first list to another one
+static void moveToList(TrieNode *node, uint8_t flag) {
+	if (node->isWord)
+		node->isWord = flag;
+	for (uint32_t children = node->children; children; children &= (children - 1)) {
+		moveToList(node->childPtrs[__builtin_ctz(children)], flag);
+	}
+}
+
+// Merges src into dst and frees what is left of src; branches missing from dst are moved, not copied
+static void mergeTrie(TrieNode *dst, TrieNode *src) {
+	dst->isWord |= src->isWord;
+	includeWordLengths(dst, src->minWordLength, src->maxWordLength);
+	dst->requiredLetters &= src->requiredLetters;
+	for (uint32_t children = src->children; children; children &= (children - 1)) {
+		int index = __builtin_ctz(children);
+		if (dst->children & (1U << index)) {
+			mergeTrie(dst->childPtrs[index], src->childPtrs[index]);
+			continue;
+		}
+		if (!dst->childPtrs) {
+			dst->childPtrs = calloc(26, sizeof(TrieNode*));
+			if (!dst->childPtrs) {
+				fprintf(stderr, "Memory allocation failed\n");
+				exit(1);
+			}
+		}
+		dst->childPtrs[index] = src->childPtrs[index];
+		dst->children |= 1U << index;
+	}
+	free(src->childPtrs);
+	free(src);
+}
+
+TrieNode* loadDictionaries(const char *const *filePaths, int numFiles, int maxWordLength) {
+	TrieNode *root = loadDictionary(filePaths[0], maxWordLength);
+	for (int i = 1; i < numFiles; i++) {
+		TrieNode *list = loadDictionary(filePaths[i], maxWordLength);
+		moveToList(list, 1U << i);
+		mergeTrie(root, list);
+	}
 	return root;
 }
 
@@ -4,9 +4,22 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+// Word lists one Trie can hold at once, one bit of isWord each
+#define MAX_WORD_LISTS 8
+
+// Longest word a Trie can hold; loading with this limit keeps the whole dictionary.
+// One below UINT8_MAX, which marks a node with no word below it.
+#define DICTIONARY_MAX_WORD_LENGTH 254
+
+// Bit mask of every letter, one bit per letter from A
+#define ALL_LETTERS ((1U << 26) - 1)
+
 typedef struct TrieNode {
 	uint32_t children;
-	bool isWord;
+	uint32_t requiredLetters; // Letters every word below this node has after it (ALL_LETTERS if none)
+	uint8_t isWord;        // Bit mask of the word lists containing the word (0 if none)
+	uint8_t minWordLength; // Length of the shortest word at or below this node (UINT8_MAX if none)
+	uint8_t maxWordLength; // Length of the longest word at or below this node
 	struct TrieNode **childPtrs;
 } TrieNode;
 
@@ -20,12 +33,96 @@ TrieNode* createNode();
 /**
  * Inserts a word into the Trie using bit vector for child representation.
  *
+ * The word is added to the first word list, and the word length bounds and
+ * required letters of every node on its path are updated to include it.
+ *
  * @param root The root node of the Trie.
  * @param word The word to be inserted.
- * @param maxWordLength The maximum allowed word length.
+ * @param maxWordLength The maximum allowed word length, capped at DICTIONARY_MAX_WORD_LENGTH.
  */
 void insertWord(TrieNode *root, const char *word, int maxWordLength);
 
+/**
+ * Inserts a word into one of the word lists held by the Trie.
+ *
+ * @param root The root node of the Trie.
+ * @param word The word to be inserted.
+ * @param maxWordLength The maximum allowed word length, capped at DICTIONARY_MAX_WORD_LENGTH.
+ * @param list The index of the word list (below MAX_WORD_LISTS).
+ */
+void insertWordInList(TrieNode *root, const char *word, int maxWordLength, int list);
+
+/**
+ * Makes a deep copy of a Trie.
+ *
+ * Every node of the copy is allocated by the calling thread, so under the
+ * kernel's first-touch policy the copy lives in that thread's NUMA node.
+ *
+ * @param root The root node of the Trie to copy.
+ * @return The root node of the copy.
+ */
+TrieNode* copyTrie(const TrieNode *root);
+
+/**
+ * Removes a word from the first word list by clearing its flag in place.
+ *
+ * Once no list contains the word, its nodes are left behind as a tombstone until
+ * the next compactTrie(). The word length bounds and required letters above it stay
+ * as they were, which only makes them looser.
+ *
+ * @param root The root node of the Trie.
+ * @param word The word to be removed.
+ * @return Whether the word was present.
+ */
+bool removeWord(TrieNode *root, const char *word);
+
+/**
+ * Frees every branch of the Trie that no longer leads to a word.
+ *
+ * The word length bounds of the remaining nodes are recomputed exactly.
+ *
+ * @param root The root node of the Trie (never freed itself).
+ * @return The number of nodes freed.
+ */
+int compactTrie(TrieNode *root);
+
+// The patch lines that changed a Trie, in the order they were applied
+typedef struct {
+	char **lines;
+	int numLines;
+} AppliedPatch;
+
+/**
+ * Applies a dictionary patch file to the first word list of a loaded Trie.
+ *
+ * Each line is "+word" to add or "-word" to remove a word; blank lines and lines
+ * starting with '#' are ignored, and a word without letters makes the patch
+ * malformed. The whole file is validated before any change is made, so a
+ * malformed patch leaves the Trie untouched. Applying the same patch twice has
+ * no further effect.
+ *
+ * @param root The root node of the Trie.
+ * @param filePath The path to the patch file.
+ * @param maxWordLength The maximum allowed word length (longer additions are skipped).
+ * @param added Set to the number of words added.
+ * @param removed Set to the number of words removed.
+ * @param applied If not NULL, an empty AppliedPatch set to the lines that changed the Trie.
+ * @return Whether the patch was valid and applied.
+ */
+bool applyDictionaryPatch(TrieNode *root, const char *filePath, int maxWordLength, int *added, int *removed,
+						  AppliedPatch *applied);
+
+/**
+ * Undoes an applied patch, restoring the first word list it changed, and empties it.
+ *
+ * Words the patch added are removed again, leaving tombstones until the next compactTrie().
+ *
+ * @param root The root node of the Trie the patch was applied to.
+ * @param applied The lines the patch applied.
+ * @return The number of words removed.
+ */
+int revertDictionaryPatch(TrieNode *root, AppliedPatch *applied);
+
 /**
  * Loads the dictionary from a file into a Trie with bit vector optimization.
  *
@@ -35,6 +132,73 @@ void insertWord(TrieNode *root, const char *word, int maxWordLength);
  */
 TrieNode* loadDictionary(const char *filePath, int maxWordLength);
 
+/**
+ * Loads several dictionaries into one merged Trie.
+ *
+ * Words of the i-th file get bit i of isWord, so a word found in several files is
+ * stored once. Each file is loaded like loadDictionary(), then merged into the first
+ * one: branches that only the later files contain are moved over instead of copied,
+ * so the merged Trie is the size of the union of the lists.
+ *
+ * @param filePaths The paths to the dictionary files.
+ * @param numFiles The number of files (1 to MAX_WORD_LISTS).
+ * @param maxWordLength The maximum allowed word length.
+ * @return The root node of the merged Trie.
+ */
+TrieNode* loadDictionaries(const char *const *filePaths, int numFiles, int maxWordLength);
+
+typedef struct DictionaryLoader DictionaryLoader;
+
+/**
+ * Starts loading a dictionary on background threads and returns immediately.
+ *
+ * Each first letter's subtrie is built independently and published to the root
+ * as soon as it is complete, so callers can start searching before the whole
+ * dictionary is ready.
+ *
+ * @param filePath The path to the dictionary file.
+ * @param maxWordLength The maximum allowed word length.
+ * @return A loader handle, to be released with finishDictionaryLoad().
+ */
+DictionaryLoader* startDictionaryLoad(const char *filePath, int maxWordLength);
+
+/**
+ * Asks the loader to build the subtries of some first letters before the others.
+ *
+ * @param loader The dictionary loader.
+ * @param letterMask Bitmask of the letters to build first (bit 0 for 'A').
+ */
+void prioritizeLetters(DictionaryLoader *loader, uint32_t letterMask);
+
+/**
+ * Waits until the subtrie of at least one letter outside knownMask is ready.
+ *
+ * @param loader The dictionary loader.
+ * @param knownMask Bitmask of the letters the caller has already seen as ready.
+ * @param readyChildren Set to the root's children bitmask restricted to ready letters.
+ * @return Bitmask of all letters whose subtries are ready (including empty ones).
+ */
+uint32_t waitForLetters(DictionaryLoader *loader, uint32_t knownMask, uint32_t *readyChildren);
+
+/**
+ * Returns the root of the Trie being loaded.
+ *
+ * Only the children reported ready by waitForLetters() may be traversed
+ * before finishDictionaryLoad() returns.
+ *
+ * @param loader The dictionary loader.
+ * @return The root node of the Trie.
+ */
+TrieNode* dictionaryRoot(DictionaryLoader *loader);
+
+/**
+ * Waits for the background threads to complete and releases the loader.
+ *
+ * @param loader The dictionary loader.
+ * @return The root node of the Trie containing the dictionary words.
+ */
+TrieNode* finishDictionaryLoad(DictionaryLoader *loader);
+
 /**
  * Frees the memory allocated for the Trie with bit vector optimization.
  *
@@ -7,8 +7,72 @@
 
 #define INITIAL_CAPACITY 128
 
+#define VISITED_WORDS(cells) (((cells) + 63) / 64)
+#define IS_VISITED(visited, cell) ((visited)[(cell) >> 6] & (1ULL << ((cell) & 63)))
+#define SET_VISITED(visited, cell) ((visited)[(cell) >> 6] |= (1ULL << ((cell) & 63)))
+#define CLEAR_VISITED(visited, cell) ((visited)[(cell) >> 6] &= ~(1ULL << ((cell) & 63)))
+
+// Reachability memo entries pack (trie node >> 4, cell, swaps) with a 2-bit state
+#define MEMO_BITS 16
+#define MEMO_DEAD 1ULL
+#define MEMO_ALIVE 2ULL
+#define MEMO_STATE_MASK 3ULL
+
+// Letter of a search frame that has not tried any yet
+#define NO_LETTER 26
+
+// Alignment of the frame stacks, so that a frame never straddles two cache lines
+#define FRAME_STACK_ALIGNMENT 64
+
+static const int DIRECTIONS[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+
+// One cell of the path being searched; frames are indexed by depth, two to a cache line
+struct SearchFrame {
+	TrieNode *node;     // Trie node of the path before this cell
+	TrieNode *child;    // Trie node of the letter being tried on this cell
+	uint32_t letters;   // Letters not tried on this cell yet
+	uint16_t row;
+	uint16_t col;
+	uint8_t gridLetter; // The cell's own letter
+	uint8_t letter;     // Letter being tried, NO_LETTER before the first
+	uint8_t swapped;    // Whether that letter replaces the cell's own
+	uint8_t neighbors;  // Free neighbors not extended to yet with that letter, one bit per direction
+	uint8_t free;       // Neighbors on the grid and off the path, once freeKnown
+	uint8_t freeKnown;
+	uint8_t swapsLeft;  // Swaps left before this cell
+	uint8_t swapDepth;  // Swaps made before this cell
+} __attribute__((aligned(32)));
+
+// Estimated search costs (about 35 ns of single-threaded search per unit) below which
+// starting a larger team of threads costs more than it saves
+#define SERIAL_COST_LIMIT 15000
+#define SMALL_TEAM_COST_LIMIT 150000
+
 const unsigned char SCORES[26] = {1, 4, 5, 3, 1, 5, 3, 4, 1, 7, 6, 3, 4, 2, 1, 1, 8, 2, 2, 2, 4, 5, 5, 7, 4, 8};
 
+// Counters of every search since the last takeSearchStats()
+static SearchStats searchStats;
+static bool memoEnabled = true;
+
+typedef struct {
+	const Grid *grid;
+	int maxWordLength;
+	DynamicWordArray *words; // Collects every word when set, otherwise only the scratch bests are kept
+	SearchScratch *scratch;
+	const SearchConstraints *constraints; // NULL for an unconstrained search
+	uint64_t *memo;                       // Shared reachability memo, or NULL
+	uint32_t boardLetters;                // Letters on the grid; any other letter takes a swap
+	SearchStats stats;                    // This thread's counters
+} SearchContext;
+
+// A unit of parallel work: every path that starts with `letter` on `startCell` and continues on `nextCell`
+typedef struct {
+	int startCell;
+	int nextCell;
+	int letter;
+	unsigned int cost;
+} SearchTask;
+
 static DynamicWordArray initDynamicWordArray() {
 	DynamicWordArray dwa;
 	dwa.array = malloc(INITIAL_CAPACITY * sizeof(WordResult));
@@ -67,6 +131,82 @@ void freeWordResult(WordResult *wr) {
 	free(wr->swapPositions);
 }
 
+WordResult copyWordResult(const WordResult *wr) {
+	WordResult copy = *wr;
+	copy.word = strdup(wr->word);
+	copy.positions = malloc(wr->length * sizeof(Position));
+	memcpy(copy.positions, wr->positions, wr->length * sizeof(Position));
+	copy.swapPositions = malloc(wr->numSwaps * sizeof(Position));
+	memcpy(copy.swapPositions, wr->swapPositions, wr->numSwaps * sizeof(Position));
+	return copy;
+}
+
+WordResult* selectBestResults(const DynamicWordArray *words, int maxSwaps) {
+	WordResult *bestResults = calloc(maxSwaps + 1, sizeof(WordResult));
+	if (!bestResults) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+
+	for (int i = 0; i < words->size; i++) {
+		const WordResult *candidate = &words->array[i];
+		int swaps = candidate->numSwaps;
+		if (swaps <= maxSwaps && candidate->score > bestResults[swaps].score) {
+			if (bestResults[swaps].word != NULL) {
+				freeWordResult(&bestResults[swaps]);
+			}
+			bestResults[swaps] = copyWordResult(candidate);
+		}
+	}
+
+	return bestResults;
+}
+
+void mergeBestWords(WordResult *bestResults, const WordResult *best, int maxSwaps) {
+	for (int i = 0; i <= maxSwaps; i++) {
+		if (best[i].score > bestResults[i].score) {
+			if (bestResults[i].word != NULL) {
+				freeWordResult(&bestResults[i]);
+			}
+			bestResults[i] = copyWordResult(&best[i]);
+		}
+	}
+}
+
+static void addSearchStats(const SearchStats *stats) {
+	__atomic_fetch_add(&searchStats.memoLookups, stats->memoLookups, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&searchStats.memoHits, stats->memoHits, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&searchStats.memoPrunes, stats->memoPrunes, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&searchStats.letterPrunes, stats->letterPrunes, __ATOMIC_RELAXED);
+}
+
+void setReachabilityMemo(bool enabled) {
+	memoEnabled = enabled;
+}
+
+SearchStats takeSearchStats(void) {
+	SearchStats stats = {
+		.memoLookups = __atomic_exchange_n(&searchStats.memoLookups, 0, __ATOMIC_RELAXED),
+		.memoHits = __atomic_exchange_n(&searchStats.memoHits, 0, __ATOMIC_RELAXED),
+		.memoPrunes = __atomic_exchange_n(&searchStats.memoPrunes, 0, __ATOMIC_RELAXED),
+		.letterPrunes = __atomic_exchange_n(&searchStats.letterPrunes, 0, __ATOMIC_RELAXED),
+		.serialSearches = __atomic_exchange_n(&searchStats.serialSearches, 0, __ATOMIC_RELAXED),
+		.smallTeamSearches = __atomic_exchange_n(&searchStats.smallTeamSearches, 0, __ATOMIC_RELAXED),
+		.fullSearches = __atomic_exchange_n(&searchStats.fullSearches, 0, __ATOMIC_RELAXED),
+		.estimatedCost = __atomic_exchange_n(&searchStats.estimatedCost, 0, __ATOMIC_RELAXED)
+	};
+	return stats;
+}
+
+void freeBestResults(WordResult *bestResults, int maxSwaps) {
+	for (int i = 0; i <= maxSwaps; i++) {
+		if (bestResults[i].word != NULL) {
+			freeWordResult(&bestResults[i]);
+		}
+	}
+	free(bestResults);
+}
+
 unsigned short calculateWordScore(const char *word, const Position *positions, const Grid *grid) {
 	unsigned short baseScore = 0;
 	unsigned short wordMultiplier = 1;
@@ -85,100 +225,769 @@ unsigned short calculateWordScore(const char *word, const Position *positions, c
 	return baseScore * wordMultiplier + longWordBonus;
 }
 
-static void dfs(const Grid *grid, int row, int col, TrieNode *node, DynamicWordArray *words,
-				bool *visited, char *currentWord, Position *currentPositions, int depth,
-				int maxWordLength, int remainingSwaps, Position *swapPositions, int swapDepth) {
-	if (depth >= maxWordLength || visited[row * grid->size + col])
+static inline void pushLetter(SearchScratch *scratch, const SearchConstraints *constraints, int letter) {
+	if (scratch->letterCounts[letter]++ == 0 && (constraints->requiredLetters & (1U << letter)))
+		scratch->missingLetters--;
+}
+
+static inline void popLetter(SearchScratch *scratch, const SearchConstraints *constraints, int letter) {
+	if (--scratch->letterCounts[letter] == 0 && (constraints->requiredLetters & (1U << letter)))
+		scratch->missingLetters++;
+}
+
+// Whether a path of `length` letters ending on (row, col) can still be extended into a word meeting the constraints
+static bool canSatisfyConstraints(const SearchContext *ctx, int row, int col, int length) {
+	const SearchConstraints *constraints = ctx->constraints;
+	const SearchScratch *scratch = ctx->scratch;
+	int lettersLeft = ctx->maxWordLength - length;
+	if (scratch->missingLetters > lettersLeft)
+		return false;
+	// Every cell of the board is still within reach
+	if (lettersLeft >= ctx->grid->size - 1 && constraints->numMustUse <= lettersLeft)
+		return true;
+
+	// Each required cell not on the path yet is at least its king-move distance away
+	int missingCells = 0;
+	for (int i = 0; i < constraints->numMustUse; i++) {
+		Position required = constraints->mustUse[i];
+		if (IS_VISITED(scratch->visited, required.row * ctx->grid->size + required.col))
+			continue;
+		int rowDistance = abs(required.row - row);
+		int colDistance = abs(required.col - col);
+		int distance = rowDistance > colDistance ? rowDistance : colDistance;
+		if (distance > lettersLeft || ++missingCells > lettersLeft)
+			return false;
+	}
+	return true;
+}
+
+static bool satisfiesConstraints(const SearchContext *ctx, int length) {
+	const SearchConstraints *constraints = ctx->constraints;
+	if (length < constraints->minLength || ctx->scratch->missingLetters > 0)
+		return false;
+	for (int i = 0; i < constraints->numMustUse; i++) {
+		Position required = constraints->mustUse[i];
+		if (!IS_VISITED(ctx->scratch->visited, required.row * ctx->grid->size + required.col))
+			return false;
+	}
+	return true;
+}
+
+// Whether some word at or below node is short enough for the search, and long enough for its constraints
+static inline bool fitsLengthLimits(const SearchContext *ctx, const TrieNode *node) {
+	return node->minWordLength <= ctx->maxWordLength &&
+		   (!ctx->constraints || node->maxWordLength >= ctx->constraints->minLength);
+}
+
+// Whether the swaps left can supply the letters every word below node needs and the board lacks
+static inline bool hasSwapsForLetters(uint32_t boardLetters, const TrieNode *node, int swaps) {
+	uint32_t missing = node->requiredLetters & ~boardLetters;
+	return missing == 0 || __builtin_popcount(missing) <= swaps;
+}
+
+static uint32_t gridLetterMask(const Grid *grid) {
+	uint32_t letters = 0;
+	for (int i = 0; i < grid->size * grid->size; i++) {
+		letters |= 1U << (grid->letters[i] - 'A');
+	}
+	return letters;
+}
+
+static void reportWord(SearchContext *ctx, int length, int swapDepth, uint8_t lists) {
+	SearchScratch *scratch = ctx->scratch;
+	if (ctx->constraints && !satisfiesConstraints(ctx, length))
+		return;
+	scratch->currentWord[length] = '\0';
+
+	if (ctx->words) {
+		addWordResult(ctx->words, createWordResult(scratch->currentWord, scratch->currentPositions, length,
+												   ctx->grid, scratch->swapPositions, swapDepth));
 		return;
+	}
+
+	// With a single list every word counts, whichever lists the Trie says it belongs to
+	if (scratch->numLists == 1)
+		lists = 1;
+	unsigned short score = calculateWordScore(scratch->currentWord, scratch->currentPositions, ctx->grid);
+	for (uint32_t remaining = lists & ((1U << scratch->numLists) - 1); remaining; remaining &= (remaining - 1)) {
+		WordResult *best = &scratch->best[__builtin_ctz(remaining) * (scratch->maxSwaps + 1) + swapDepth];
+		if (score > best->score) {
+			best->score = score;
+			best->length = length;
+			best->numSwaps = swapDepth;
+			memcpy(best->word, scratch->currentWord, length + 1);
+			memcpy(best->positions, scratch->currentPositions, length * sizeof(Position));
+			memcpy(best->swapPositions, scratch->swapPositions, swapDepth * sizeof(Position));
+		}
+	}
+}
+
+// The exact memo key of a state, or 0 if it does not fit in an entry
+static inline uint64_t memoKey(const TrieNode *node, int cell, int swaps) {
+	uint64_t address = (uintptr_t)node >> 4;
+	if ((address >> 44) != 0 || cell >= 4096 || swaps >= 16)
+		return 0;
+	return (address << 18) | ((uint64_t)cell << 6) | ((uint64_t)swaps << 2);
+}
+
+/**
+ * Whether a path whose last letter (leading to node) is on cell can be extended into a
+ * word with at most `swaps` more swaps, ignoring which cells are already visited.
+ * Since revisiting cells is allowed here, a state found dead is dead for every real path.
+ * Results are memoized in a lossy table shared by all threads with plain atomic stores.
+ */
+static bool canContinue(SearchContext *ctx, const TrieNode *node, int cell, int swaps) {
+	const Grid *grid = ctx->grid;
+	uint64_t key = memoKey(node, cell, swaps);
+	uint64_t *entry = &ctx->memo[(key * 0x9E3779B97F4A7C15ULL) >> (64 - MEMO_BITS)];
+	if (key != 0) {
+		uint64_t cached = __atomic_load_n(entry, __ATOMIC_RELAXED);
+		ctx->stats.memoLookups++;
+		if ((cached & ~MEMO_STATE_MASK) == key) {
+			ctx->stats.memoHits++;
+			return (cached & MEMO_STATE_MASK) == MEMO_ALIVE;
+		}
+	}
 
-	visited[row * grid->size + col] = true;
+	int row = cell / grid->size;
+	int col = cell % grid->size;
+	bool alive = false;
+	for (int r = row - 1; r <= row + 1 && !alive; r++) {
+		for (int c = col - 1; c <= col + 1 && !alive; c++) {
+			if (r < 0 || r >= grid->size || c < 0 || c >= grid->size || (r == row && c == col))
+				continue;
+			int next = r * grid->size + c;
+			int gridLetter = grid->letters[next] - 'A';
+			uint32_t letters = node->children & (swaps > 0 ? ~0U : 1U << gridLetter);
+			while (letters && !alive) {
+				int letter = __builtin_ctz(letters);
+				letters &= (letters - 1);
+				const TrieNode *child = node->childPtrs[letter];
+				int swapsLeft = swaps - (letter != gridLetter);
+				if (!fitsLengthLimits(ctx, child) || !hasSwapsForLetters(ctx->boardLetters, child, swapsLeft))
+					continue;
+				alive = child->isWord || (child->children && canContinue(ctx, child, next, swapsLeft));
+			}
+		}
+	}
+
+	if (key != 0)
+		__atomic_store_n(entry, key | (alive ? MEMO_ALIVE : MEMO_DEAD), __ATOMIC_RELAXED);
+	return alive;
+}
+
+// Pushes a frame for the path's next cell, which must be off the path, unless no letter of node fits on it
+static inline bool enterCell(SearchContext *ctx, SearchFrame *frame, int row, int col, TrieNode *node,
+							 int swapsLeft, int swapDepth) {
+	int cell = row * ctx->grid->size + col;
+	int gridLetter = ctx->grid->letters[cell] - 'A';
+	uint32_t letters = node->children & (swapsLeft > 0 ? ALL_LETTERS : 1U << gridLetter);
+	if (!letters)
+		return false;
+
+	SET_VISITED(ctx->scratch->visited, cell);
+	frame->node = node;
+	frame->letters = letters;
+	frame->row = row;
+	frame->col = col;
+	frame->gridLetter = gridLetter;
+	frame->letter = NO_LETTER;
+	frame->neighbors = 0;
+	frame->freeKnown = false;
+	frame->swapsLeft = swapsLeft;
+	frame->swapDepth = swapDepth;
+	return true;
+}
+
+/**
+ * The directions of DIRECTIONS leading from (row, col) to a cell on the grid and off the
+ * path. The path below a frame stays the same while the frame is on the stack, so this is
+ * worked out once per frame rather than for every letter and neighbor.
+ */
+static inline uint8_t freeNeighbors(const SearchContext *ctx, int row, int col) {
+	int size = ctx->grid->size;
+	const uint64_t *visited = ctx->scratch->visited;
+	int cell = row * size + col;
+	const int offsets[8] = {-size - 1, -size, -size + 1, -1, 1, size - 1, size, size + 1};
+
+	unsigned int directions = 0xFF;
+	if (row == 0)
+		directions &= ~0x07;
+	if (row == size - 1)
+		directions &= ~0xE0;
+	if (col == 0)
+		directions &= ~0x29;
+	if (col == size - 1)
+		directions &= ~0x94;
+
+	// Off-grid directions look at the cell itself, which is on the path, instead
+	unsigned int free = 0;
+	for (int direction = 0; direction < 8; direction++) {
+		int neighbor = cell + ((directions >> direction) & 1 ? offsets[direction] : 0);
+		free |= (unsigned int)!IS_VISITED(visited, neighbor) << direction;
+	}
+	return free;
+}
 
-	unsigned int children = node->children;
-	char gridLetter = grid->letters[row * grid->size + col];
-	bool isGridLetterValid = (children & (1U << (gridLetter - 'A')));
+/**
+ * Moves a frame on to the next letter worth extending the path from: the cell's own
+ * letter first, then each substitution in alphabetical order. Words ending on the cell
+ * are reported along the way, including those of letters that lead nowhere further.
+ * Returns false once every letter has been tried.
+ */
+static bool nextLetter(SearchContext *ctx, SearchFrame *frame, int depth) {
+	// Work on copies, which the stores into the word buffers cannot alias
+	SearchScratch *scratch = ctx->scratch;
+	const TrieNode *node = frame->node;
+	uint32_t letters = frame->letters;
+	int gridLetter = frame->gridLetter;
+	int row = frame->row;
+	int col = frame->col;
+	int swapsLeft = frame->swapsLeft;
+	int swapDepth = frame->swapDepth;
 
-	if (isGridLetterValid) {
-		TrieNode *child = node->childPtrs[gridLetter - 'A'];
-		currentWord[depth] = gridLetter;
-		currentPositions[depth] = (Position){row, col};
+	while (letters) {
+		int letter = (letters & (1U << gridLetter)) ? gridLetter : __builtin_ctz(letters);
+		letters &= ~(1U << letter);
+		TrieNode *child = node->childPtrs[letter];
+		bool swapped = letter != gridLetter;
+
+		// A substitution spends a swap; the letters below the child that the board lacks need the rest
+		if (!hasSwapsForLetters(ctx->boardLetters, child, swapsLeft - swapped)) {
+			ctx->stats.letterPrunes++;
+			continue;
+		}
+
+		scratch->currentWord[depth] = 'A' + letter;
+		scratch->currentPositions[depth] = (Position){row, col};
+		if (swapped)
+			scratch->swapPositions[swapDepth] = (Position){row, col};
+		bool viable = depth + 1 < ctx->maxWordLength && fitsLengthLimits(ctx, child);
+		if (ctx->constraints) {
+			pushLetter(scratch, ctx->constraints, letter);
+			viable = viable && canSatisfyConstraints(ctx, row, col, depth + 1);
+		}
+		if (viable && ctx->memo && !canContinue(ctx, child, row * ctx->grid->size + col, swapsLeft - swapped)) {
+			ctx->stats.memoPrunes++;
+			viable = false;
+		}
 
 		if (child->isWord && depth > 0) {
-			currentWord[depth + 1] = '\0';
-			addWordResult(words, createWordResult(currentWord, currentPositions, depth + 1, grid, swapPositions, swapDepth));
-		}
-
-		const int directions[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1},
-									  {0, 1},   {1, -1}, {1, 0},  {1, 1}};
-		for (int i = 0; i < 8; i++) {
-			int newRow = row + directions[i][0];
-			int newCol = col + directions[i][1];
-			if (newRow >= 0 && newRow < grid->size && newCol >= 0 && newCol < grid->size) {
-				dfs(grid, newRow, newCol, child, words, visited, currentWord,
-					currentPositions, depth + 1, maxWordLength, remainingSwaps,
-					swapPositions, swapDepth);
+			reportWord(ctx, depth + 1, swapDepth + swapped, child->isWord);
+		}
+		if (viable && !frame->freeKnown) {
+			frame->free = freeNeighbors(ctx, row, col);
+			frame->freeKnown = true;
+		}
+		if (!viable || !frame->free) {
+			if (ctx->constraints)
+				popLetter(scratch, ctx->constraints, letter);
+			continue;
+		}
+
+		frame->letters = letters;
+		frame->child = child;
+		frame->letter = letter;
+		frame->swapped = swapped;
+		frame->neighbors = frame->free;
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Finds every word whose path continues from node onto (row, col), depth first.
+ *
+ * The search runs on the scratch's frame stack rather than the call stack: each step
+ * either extends the path from the top frame to its next neighbor, or moves the top
+ * frame on to its next letter and pops it once none is left.
+ */
+static void dfs(SearchContext *ctx, int row, int col, TrieNode *node, int depth, int swapsLeft, int swapDepth) {
+	SearchScratch *scratch = ctx->scratch;
+	SearchFrame *frames = scratch->frames;
+	int size = ctx->grid->size;
+	int base = depth;
+	if (depth >= ctx->maxWordLength || IS_VISITED(scratch->visited, row * size + col) ||
+		!enterCell(ctx, &frames[depth], row, col, node, swapsLeft, swapDepth))
+		return;
+
+	while (depth >= base) {
+		SearchFrame *frame = &frames[depth];
+		unsigned int neighbors = frame->neighbors;
+		bool pushed = false;
+		while (neighbors && !pushed) {
+			int direction = __builtin_ctz(neighbors);
+			neighbors &= neighbors - 1;
+			pushed = enterCell(ctx, &frames[depth + 1], frame->row + DIRECTIONS[direction][0],
+							   frame->col + DIRECTIONS[direction][1], frame->child, frame->swapsLeft - frame->swapped,
+							   frame->swapDepth + frame->swapped);
+		}
+		frame->neighbors = neighbors;
+		if (pushed) {
+			depth++;
+			continue;
+		}
+
+		if (ctx->constraints && frame->letter != NO_LETTER)
+			popLetter(scratch, ctx->constraints, frame->letter);
+		if (!nextLetter(ctx, frame, depth)) {
+			CLEAR_VISITED(scratch->visited, frame->row * size + frame->col);
+			depth--;
+		}
+	}
+}
+
+// Scratch space with one set of best words per word list
+static SearchScratch* createListSearchScratch(int gridSize, int maxWordLength, int maxSwaps, int numLists) {
+	SearchScratch *scratch = malloc(sizeof(SearchScratch));
+	if (!scratch) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	scratch->gridSize = gridSize;
+	scratch->maxWordLength = maxWordLength;
+	scratch->maxSwaps = maxSwaps;
+	scratch->numLists = numLists;
+	scratch->visited = calloc(VISITED_WORDS(gridSize * gridSize), sizeof(uint64_t));
+	scratch->currentWord = malloc((maxWordLength + 1) * sizeof(char));
+	scratch->currentPositions = malloc(maxWordLength * sizeof(Position));
+	scratch->swapPositions = malloc(maxWordLength * sizeof(Position));
+	if (posix_memalign((void **)&scratch->frames, FRAME_STACK_ALIGNMENT, (maxWordLength + 1) * sizeof(SearchFrame)) != 0) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	scratch->best = calloc(numLists * (maxSwaps + 1), sizeof(WordResult));
+	for (int i = 0; i < numLists * (maxSwaps + 1); i++) {
+		scratch->best[i].word = malloc((maxWordLength + 1) * sizeof(char));
+		scratch->best[i].positions = malloc(maxWordLength * sizeof(Position));
+		scratch->best[i].swapPositions = malloc(maxWordLength * sizeof(Position));
+	}
+	return scratch;
+}
+
+SearchScratch* createSearchScratch(int gridSize, int maxWordLength, int maxSwaps) {
+	return createListSearchScratch(gridSize, maxWordLength, maxSwaps, 1);
+}
+
+void freeSearchScratch(SearchScratch *scratch) {
+	for (int i = 0; i < scratch->numLists * (scratch->maxSwaps + 1); i++) {
+		freeWordResult(&scratch->best[i]);
+	}
+	free(scratch->best);
+	free(scratch->visited);
+	free(scratch->currentWord);
+	free(scratch->currentPositions);
+	free(scratch->swapPositions);
+	free(scratch->frames);
+	free(scratch);
+}
+
+// Every thread's scratch space, so that freeThreadScratch() can release them all
+static SearchScratch **threadScratches = NULL;
+static int numThreadScratches = 0;
+static int threadScratchCapacity = 0;
+
+// Bumped by freeThreadScratch(), which leaves every thread's pointer dangling
+static unsigned int scratchGeneration = 0;
+
+// The calling thread's scratch space, kept for the next search of the same shape
+static __thread SearchScratch *threadScratch = NULL;
+static __thread unsigned int threadScratchGeneration = 0;
+
+/**
+ * Returns the calling thread's scratch space for a search, allocating it only when the
+ * previous search had other dimensions. OpenMP keeps its threads between parallel
+ * regions, so a batch of same-sized boards allocates each thread's buffers once.
+ */
+static SearchScratch* acquireThreadScratch(int gridSize, int maxWordLength, int maxSwaps, int numLists) {
+	SearchScratch *scratch = threadScratchGeneration == scratchGeneration ? threadScratch : NULL;
+	if (scratch != NULL && scratch->gridSize == gridSize && scratch->maxWordLength == maxWordLength &&
+		scratch->maxSwaps == maxSwaps && scratch->numLists == numLists) {
+		// Avoided cells stay marked visited after a constrained search
+		memset(scratch->visited, 0, VISITED_WORDS(gridSize * gridSize) * sizeof(uint64_t));
+		return scratch;
+	}
+
+	SearchScratch *replacement = createListSearchScratch(gridSize, maxWordLength, maxSwaps, numLists);
+	#pragma omp critical (threadScratches)
+	{
+		int slot = 0;
+		while (slot < numThreadScratches && threadScratches[slot] != scratch)
+			slot++;
+		if (slot == numThreadScratches) {
+			if (numThreadScratches == threadScratchCapacity) {
+				threadScratchCapacity = threadScratchCapacity ? threadScratchCapacity * 2 : 16;
+				threadScratches = realloc(threadScratches, threadScratchCapacity * sizeof(SearchScratch *));
+				if (!threadScratches) {
+					fprintf(stderr, "Memory reallocation failed\n");
+					exit(1);
+				}
 			}
+			numThreadScratches++;
 		}
+		threadScratches[slot] = replacement;
 	}
+	if (scratch != NULL)
+		freeSearchScratch(scratch);
+
+	threadScratch = replacement;
+	threadScratchGeneration = scratchGeneration;
+	return replacement;
+}
+
+void freeThreadScratch(void) {
+	for (int i = 0; i < numThreadScratches; i++) {
+		freeSearchScratch(threadScratches[i]);
+	}
+	free(threadScratches);
+	threadScratches = NULL;
+	numThreadScratches = 0;
+	threadScratchCapacity = 0;
+	scratchGeneration++;
+}
 
+static int countNeighbors(const Grid *grid, int cell) {
+	int row = cell / grid->size;
+	int col = cell % grid->size;
+	int rows = (row > 0) + 1 + (row < grid->size - 1);
+	int cols = (col > 0) + 1 + (col < grid->size - 1);
+	return rows * cols - 1;
+}
+
+// Rough count of the partial paths below a task, used to schedule the most expensive tasks first
+static unsigned int estimateTaskCost(const Grid *grid, const TrieNode *node, int nextCell, int remainingSwaps) {
+	int degree = countNeighbors(grid, nextCell);
+	int nextLetter = grid->letters[nextCell] - 'A';
+	unsigned int cost = 0;
+
+	if (node->children & (1U << nextLetter)) {
+		cost += 1 + __builtin_popcount(node->childPtrs[nextLetter]->children) * degree;
+	}
 	if (remainingSwaps > 0) {
+		unsigned int children = node->children;
 		while (children) {
-			int letter = __builtin_ctz(children);
-			char currentLetter = 'A' + letter;
-
-			if (currentLetter != gridLetter) {
-				TrieNode *child = node->childPtrs[letter];
-				currentWord[depth] = currentLetter;
-				currentPositions[depth] = (Position){row, col};
-				swapPositions[swapDepth] = (Position){row, col};
-
-				if (child->isWord && depth > 0) {
-					currentWord[depth + 1] = '\0';
-					addWordResult(words, createWordResult(currentWord, currentPositions, depth + 1, grid, swapPositions, swapDepth + 1));
-				}
+			cost += 1 + __builtin_popcount(node->childPtrs[__builtin_ctz(children)]->children) * degree * remainingSwaps;
+			children &= (children - 1);
+		}
+	}
+	return cost;
+}
+
+static int compareTasksByCost(const void *a, const void *b) {
+	const SearchTask *ta = a;
+	const SearchTask *tb = b;
+	return (tb->cost > ta->cost) - (tb->cost < ta->cost);
+}
+
+/**
+ * Splits the search at depth 1, so that even a large board with few start cells yields
+ * plenty of similarly sized units of work, and orders the tasks by estimated cost.
+ * Only paths starting with one of firstLetters (a subset of trie->children) are covered.
+ */
+static SearchTask* createSearchTasks(const Grid *grid, const TrieNode *trie, uint32_t firstLetters,
+									 int maxWordLength, int maxSwaps, int *numTasks) {
+	int numCells = grid->size * grid->size;
+	SearchTask *tasks = malloc(numCells * 26 * 8 * sizeof(SearchTask));
+	if (!tasks) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+
+	int count = 0;
+	uint32_t boardLetters = gridLetterMask(grid);
+	for (int startCell = 0; startCell < numCells && maxWordLength > 1; startCell++) {
+		int gridLetter = grid->letters[startCell] - 'A';
+		unsigned int letters = firstLetters;
+		if (maxSwaps == 0)
+			letters &= (1U << gridLetter);
+
+		while (letters) {
+			int letter = __builtin_ctz(letters);
+			letters &= (letters - 1);
+			int remainingSwaps = maxSwaps - (letter != gridLetter);
+			const TrieNode *node = trie->childPtrs[letter];
+			if (!hasSwapsForLetters(boardLetters, node, remainingSwaps))
+				continue;
 
-				const int directions[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1},
-											  {0, 1},   {1, -1}, {1, 0},  {1, 1}};
-				for (int i = 0; i < 8; i++) {
-					int newRow = row + directions[i][0];
-					int newCol = col + directions[i][1];
-					if (newRow >= 0 && newRow < grid->size && newCol >= 0 && newCol < grid->size) {
-						dfs(grid, newRow, newCol, child, words, visited, currentWord,
-							currentPositions, depth + 1, maxWordLength, remainingSwaps - 1,
-							swapPositions, swapDepth + 1);
-					}
+			int row = startCell / grid->size;
+			int col = startCell % grid->size;
+			for (int r = row - 1; r <= row + 1; r++) {
+				for (int c = col - 1; c <= col + 1; c++) {
+					if (r < 0 || r >= grid->size || c < 0 || c >= grid->size || (r == row && c == col))
+						continue;
+					int nextCell = r * grid->size + c;
+					unsigned int cost = estimateTaskCost(grid, node, nextCell, remainingSwaps);
+					if (cost > 0)
+						tasks[count++] = (SearchTask){startCell, nextCell, letter, cost};
 				}
 			}
-
-			children &= (children - 1);
 		}
 	}
 
-	visited[row * grid->size + col] = false;
+	qsort(tasks, count, sizeof(SearchTask), compareTasksByCost);
+	*numTasks = count;
+	return tasks;
+}
+
+/**
+ * Picks the team size for a search from the summed task cost estimates, which already
+ * account for the board's letters, the trie's fan-out at depth two and the swap budget.
+ * Cheap searches run serially, since starting threads and allocating their scratch
+ * space would take longer than the search itself. The sum is multiplied by costScale
+ * when the tasks are only part of a larger search, such as one wave of a pipelined solve.
+ */
+static int chooseThreadCount(const SearchTask *tasks, int numTasks, int costScale) {
+	unsigned long long cost = 0;
+	for (int t = 0; t < numTasks; t++) {
+		cost += tasks[t].cost;
+	}
+	__atomic_fetch_add(&searchStats.estimatedCost, cost, __ATOMIC_RELAXED);
+	cost *= costScale;
+
+	int maxThreads = omp_get_max_threads();
+	int numThreads = maxThreads;
+	unsigned long long *counter = &searchStats.fullSearches;
+	if (cost < SERIAL_COST_LIMIT || maxThreads == 1) {
+		numThreads = 1;
+		counter = &searchStats.serialSearches;
+	} else if (cost < SMALL_TEAM_COST_LIMIT && maxThreads > SMALL_TEAM_THREADS) {
+		numThreads = SMALL_TEAM_THREADS;
+		counter = &searchStats.smallTeamSearches;
+	}
+	__atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+	return numThreads;
+}
+
+static void runSearchTask(SearchContext *ctx, TrieNode *trie, int maxSwaps, const SearchTask *task) {
+	const Grid *grid = ctx->grid;
+	SearchScratch *scratch = ctx->scratch;
+	Position start = {task->startCell / grid->size, task->startCell % grid->size};
+	int swapDepth = (grid->letters[task->startCell] - 'A' != task->letter);
+
+	// Avoided cells are marked visited for the whole search
+	if (IS_VISITED(scratch->visited, task->startCell))
+		return;
+
+	scratch->currentWord[0] = 'A' + task->letter;
+	scratch->currentPositions[0] = start;
+	scratch->swapPositions[0] = start;
+
+	SET_VISITED(scratch->visited, task->startCell);
+	bool viable = true;
+	if (ctx->constraints) {
+		pushLetter(scratch, ctx->constraints, task->letter);
+		viable = canSatisfyConstraints(ctx, start.row, start.col, 1);
+	}
+	if (viable) {
+		dfs(ctx, task->nextCell / grid->size, task->nextCell % grid->size, trie->childPtrs[task->letter],
+			1, maxSwaps - swapDepth, swapDepth);
+	}
+	if (ctx->constraints)
+		popLetter(scratch, ctx->constraints, task->letter);
+	CLEAR_VISITED(scratch->visited, task->startCell);
+}
+
+// Marks the avoided cells visited and resets the letter counts of a thread's scratch
+static void applyConstraints(SearchContext *ctx) {
+	const SearchConstraints *constraints = ctx->constraints;
+	SearchScratch *scratch = ctx->scratch;
+	for (int i = 0; i < constraints->numAvoid; i++) {
+		SET_VISITED(scratch->visited, constraints->avoid[i].row * ctx->grid->size + constraints->avoid[i].col);
+	}
+	memset(scratch->letterCounts, 0, sizeof(scratch->letterCounts));
+	scratch->missingLetters = __builtin_popcount(constraints->requiredLetters);
+}
+
+static void resetBestWords(SearchScratch *scratch, int maxSwaps) {
+	for (int list = 0; list < scratch->numLists; list++) {
+		for (int i = 0; i <= maxSwaps; i++) {
+			scratch->best[list * (scratch->maxSwaps + 1) + i].score = 0;
+		}
+	}
 }
 
 DynamicWordArray findWords(const Grid *grid, TrieNode *trie, int maxWordLength, int maxSwaps) {
 	DynamicWordArray words = initDynamicWordArray();
+	int numTasks;
+	SearchTask *tasks = createSearchTasks(grid, trie, trie->children, maxWordLength, maxSwaps, &numTasks);
+	int numThreads = chooseThreadCount(tasks, numTasks, 1);
 
-	#pragma omp parallel
+	#pragma omp parallel num_threads(numThreads) if (numThreads > 1)
 	{
-		bool *visited = calloc(grid->size * grid->size, sizeof(bool));
-		char *currentWord = malloc((maxWordLength + 1) * sizeof(char));
-		Position *currentPositions = malloc(maxWordLength * sizeof(Position));
-		Position *swapPositions = malloc(maxWordLength * sizeof(Position));
-
-		#pragma omp for collapse(2)
-		for (int r = 0; r < grid->size; r++) {
-			for (int c = 0; c < grid->size; c++) {
-				dfs(grid, r, c, trie, &words, visited, currentWord,
-					currentPositions, 0, maxWordLength, maxSwaps, swapPositions, 0);
+		SearchContext ctx = {
+			.grid = grid,
+			.maxWordLength = maxWordLength,
+			.words = &words,
+			.scratch = acquireThreadScratch(grid->size, maxWordLength, maxSwaps, 1),
+			.boardLetters = gridLetterMask(grid)
+		};
+
+		#pragma omp for schedule(dynamic, 1)
+		for (int t = 0; t < numTasks; t++) {
+			runSearchTask(&ctx, trie, maxSwaps, &tasks[t]);
+		}
+	}
+
+	free(tasks);
+	return words;
+}
+
+static WordResult* allocateBestResults(int maxSwaps) {
+	WordResult *bestResults = calloc(maxSwaps + 1, sizeof(WordResult));
+	if (!bestResults) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	return bestResults;
+}
+
+/**
+ * Runs the tasks in parallel and merges each thread's best words into bestResults.
+ * With replicas, each thread searches its node-local copy instead of trie.
+ * With constraints, only words satisfying them are kept. The team size is chosen from
+ * the tasks' estimated cost, scaled by costScale (see chooseThreadCount()).
+ * bestResults holds maxSwaps + 1 results for each of the numLists word lists.
+ */
+static void searchBestWords(const Grid *grid, TrieNode *trie, const TrieReplicas *replicas,
+							const SearchConstraints *constraints, int maxWordLength, int maxSwaps, int numLists,
+							const SearchTask *tasks, int numTasks, int costScale, WordResult *bestResults) {
+	// Without swaps the search is too short for the memo to pay for itself
+	uint64_t *memo = NULL;
+	if (memoEnabled && maxSwaps > 0) {
+		memo = calloc(1ULL << MEMO_BITS, sizeof(uint64_t));
+		if (!memo) {
+			fprintf(stderr, "Memory allocation failed\n");
+			exit(1);
+		}
+	}
+
+	int numThreads = chooseThreadCount(tasks, numTasks, costScale);
+	uint32_t boardLetters = gridLetterMask(grid);
+
+	#pragma omp parallel num_threads(numThreads) if (numThreads > 1)
+	{
+		TrieNode *root = replicas ? localReplica(replicas) : trie;
+		SearchContext ctx = {
+			.grid = grid,
+			.maxWordLength = maxWordLength,
+			.words = NULL,
+			.scratch = acquireThreadScratch(grid->size, maxWordLength, maxSwaps, numLists),
+			.constraints = constraints,
+			.memo = memo,
+			.boardLetters = boardLetters
+		};
+		resetBestWords(ctx.scratch, maxSwaps);
+		if (constraints)
+			applyConstraints(&ctx);
+
+		#pragma omp for schedule(dynamic, 1)
+		for (int t = 0; t < numTasks; t++) {
+			runSearchTask(&ctx, root, maxSwaps, &tasks[t]);
+		}
+
+		#pragma omp critical
+		mergeBestWords(bestResults, ctx.scratch->best, numLists * (maxSwaps + 1) - 1);
+		addSearchStats(&ctx.stats);
+	}
+	free(memo);
+}
+
+WordResult* findBestResults(const Grid *grid, TrieNode *trie, int maxWordLength, int maxSwaps) {
+	return findBestResultsConstrained(grid, trie, maxWordLength, maxSwaps, NULL);
+}
+
+WordResult* findBestResultsConstrained(const Grid *grid, TrieNode *trie, int maxWordLength, int maxSwaps,
+									   const SearchConstraints *constraints) {
+	return findBestResultsPerList(grid, trie, maxWordLength, maxSwaps, 1, constraints);
+}
+
+WordResult* findBestResultsPerList(const Grid *grid, TrieNode *trie, int maxWordLength, int maxSwaps, int numLists,
+								   const SearchConstraints *constraints) {
+	WordResult *bestResults = allocateBestResults(numLists * (maxSwaps + 1) - 1);
+	if (constraints) {
+		if (constraints->maxLength > 0 && constraints->maxLength < maxWordLength)
+			maxWordLength = constraints->maxLength;
+
+		// No path can both use and avoid a cell
+		for (int i = 0; i < constraints->numMustUse; i++) {
+			for (int j = 0; j < constraints->numAvoid; j++) {
+				if (constraints->mustUse[i].row == constraints->avoid[j].row &&
+					constraints->mustUse[i].col == constraints->avoid[j].col)
+					return bestResults;
 			}
 		}
+	}
+
+	int numTasks;
+	SearchTask *tasks = createSearchTasks(grid, trie, trie->children, maxWordLength, maxSwaps, &numTasks);
+	searchBestWords(grid, trie, NULL, constraints, maxWordLength, maxSwaps, numLists, tasks, numTasks, 1,
+					bestResults);
+	free(tasks);
+	return bestResults;
+}
+
+WordResult* findBestResultsReplicated(const Grid *grid, const TrieReplicas *replicas, int maxWordLength,
+									  int maxSwaps) {
+	WordResult *bestResults = allocateBestResults(maxSwaps);
+	TrieNode *trie = replicas->roots[0];
+	int numTasks;
+	SearchTask *tasks = createSearchTasks(grid, trie, trie->children, maxWordLength, maxSwaps, &numTasks);
+	searchBestWords(grid, trie, replicas, NULL, maxWordLength, maxSwaps, 1, tasks, numTasks, 1, bestResults);
+	free(tasks);
+	return bestResults;
+}
+
+WordResult* findBestResultsWhileLoading(const Grid *grid, DictionaryLoader *loader, int maxWordLength, int maxSwaps) {
+	WordResult *bestResults = allocateBestResults(maxSwaps);
+	TrieNode *root = dictionaryRoot(loader);
+
+	// Without swaps, only the subtries of letters on the board can start a word
+	uint32_t neededMask = (1U << 26) - 1;
+	if (maxSwaps == 0) {
+		neededMask = 0;
+		for (int i = 0; i < grid->size * grid->size; i++) {
+			neededMask |= 1U << (grid->letters[i] - 'A');
+		}
+	}
+	prioritizeLetters(loader, neededMask);
+
+	// Search each batch of first letters as soon as their subtries are published
+	uint32_t searchedMask = 0;
+	while ((searchedMask & neededMask) != neededMask) {
+		uint32_t readyChildren;
+		uint32_t readyMask = waitForLetters(loader, searchedMask, &readyChildren);
+		uint32_t batch = readyChildren & ~searchedMask & neededMask;
 
-		free(visited);
-		free(currentWord);
-		free(currentPositions);
-		free(swapPositions);
+		// A wave is judged as if it were as costly as all the letters still to come, so a
+		// hard board split into many small waves still gets the whole team for each of them
+		int remaining = __builtin_popcount(neededMask & ~searchedMask);
+		int costScale = batch ? (remaining + __builtin_popcount(batch) - 1) / __builtin_popcount(batch) : 1;
+		searchedMask = readyMask;
+
+		int numTasks;
+		SearchTask *tasks = createSearchTasks(grid, root, batch, maxWordLength, maxSwaps, &numTasks);
+		searchBestWords(grid, root, NULL, NULL, maxWordLength, maxSwaps, 1, tasks, numTasks, costScale, bestResults);
+		free(tasks);
 	}
 
-	return words;
+	return bestResults;
+}
+
+const WordResult* findBestWords(const Grid *grid, TrieNode *trie, int maxWordLength, int maxSwaps, SearchScratch *scratch) {
+	SearchContext ctx = {
+		.grid = grid,
+		.maxWordLength = maxWordLength,
+		.words = NULL,
+		.scratch = scratch,
+		.boardLetters = gridLetterMask(grid)
+	};
+
+	resetBestWords(scratch, maxSwaps);
+	for (int r = 0; r < grid->size; r++) {
+		for (int c = 0; c < grid->size; c++) {
+			dfs(&ctx, r, c, trie, 0, maxSwaps, 0);
+		}
+	}
+
+	return scratch->best;
 }
\ No newline at end of file
@@ -3,6 +3,12 @@
 
 #include "grid.h"
 #include "trie.h"
+#include "topology.h"
+
+extern const unsigned char SCORES[26];
+
+// Most swaps a search can track; its frames keep swap counts in a byte
+#define MAX_SWAPS UINT8_MAX
 
 typedef struct {
 	char *word;
@@ -19,6 +25,49 @@ typedef struct {
 	int capacity;
 } DynamicWordArray;
 
+typedef struct SearchFrame SearchFrame;
+
+typedef struct {
+	uint64_t *visited; // Bitset over grid cells
+	char *currentWord;
+	Position *currentPositions;
+	Position *swapPositions;
+	SearchFrame *frames;  // Stack of the depth-first search, one frame per letter of the path
+	WordResult *best;     // maxSwaps + 1 best words for each word list
+	int gridSize;
+	int maxWordLength;
+	int maxSwaps;
+	int numLists;
+	int letterCounts[26]; // Occurrences of each letter in currentWord, kept only under constraints
+	int missingLetters;   // Required letters not yet in currentWord
+} SearchScratch;
+
+// Threads used for searches of moderate estimated cost
+#define SMALL_TEAM_THREADS 4
+
+// Counters collected by the searches, for --stats
+typedef struct {
+	unsigned long long memoLookups; // Reachability memo probes
+	unsigned long long memoHits;    // Probes answered from the memo
+	unsigned long long memoPrunes;  // Branches skipped because no word was reachable
+	unsigned long long letterPrunes; // Branches skipped because the board lacks too many letters below them
+	unsigned long long serialSearches;    // Searches estimated cheap enough to run on one thread
+	unsigned long long smallTeamSearches; // Searches run on SMALL_TEAM_THREADS threads at most
+	unsigned long long fullSearches;      // Searches run on every available thread
+	unsigned long long estimatedCost;     // Sum of the searches' cost estimates
+} SearchStats;
+
+// Restrictions on the words a search may return, enforced while searching
+typedef struct {
+	int minLength;            // 0 for no minimum
+	int maxLength;            // 0 for no limit beyond maxWordLength
+	uint32_t requiredLetters; // Bit mask of letters that must all appear in the word
+	Position *mustUse;        // Cells the path must pass through
+	int numMustUse;
+	Position *avoid;          // Cells the path may not use
+	int numAvoid;
+} SearchConstraints;
+
 /**
  * Finds all valid words in the grid using depth-first search.
  *
@@ -30,6 +79,122 @@ typedef struct {
  */
 DynamicWordArray findWords(const Grid *grid, TrieNode *trie, int maxWordLength, int maxSwaps);
 
+/**
+ * Finds the highest scoring word for each number of swaps in parallel.
+ *
+ * Only one result per swap count and thread is kept during the search, so memory
+ * stays bounded regardless of the board size.
+ *
+ * @param grid The game grid.
+ * @param trie The Trie containing the dictionary.
+ * @param maxWordLength The maximum allowed word length.
+ * @param maxSwaps The maximum amount of swaps.
+ * @return An array of maxSwaps + 1 WordResults, with a NULL word where nothing was found.
+ */
+WordResult* findBestResults(const Grid *grid, TrieNode *trie, int maxWordLength, int maxSwaps);
+
+/**
+ * Like findBestResults(), but only returns words that satisfy the constraints.
+ *
+ * Avoided cells are marked visited before the search starts, and branches that can
+ * no longer reach a required cell or fit the missing required letters within the
+ * length limit are cut off, so constrained queries search less than unconstrained ones.
+ *
+ * @param grid The game grid.
+ * @param trie The Trie containing the dictionary.
+ * @param maxWordLength The maximum allowed word length.
+ * @param maxSwaps The maximum amount of swaps.
+ * @param constraints The constraints, or NULL for none.
+ * @return An array of maxSwaps + 1 WordResults, with a NULL word where nothing was found.
+ */
+WordResult* findBestResultsConstrained(const Grid *grid, TrieNode *trie, int maxWordLength, int maxSwaps,
+									   const SearchConstraints *constraints);
+
+/**
+ * Finds the highest scoring word for each word list and number of swaps in one search.
+ *
+ * The Trie holds several word lists merged together (see loadDictionaries()), so words
+ * shared by the lists are only walked once, and each word found updates the best results
+ * of every list it belongs to.
+ *
+ * @param grid The game grid.
+ * @param trie The merged Trie.
+ * @param maxWordLength The maximum allowed word length.
+ * @param maxSwaps The maximum amount of swaps.
+ * @param numLists The number of word lists (at most MAX_WORD_LISTS).
+ * @param constraints The constraints, or NULL for none.
+ * @return An array of numLists * (maxSwaps + 1) WordResults, list by list, with a NULL word where
+ *         nothing was found. Free it with freeBestResults(results, numLists * (maxSwaps + 1) - 1).
+ */
+WordResult* findBestResultsPerList(const Grid *grid, TrieNode *trie, int maxWordLength, int maxSwaps, int numLists,
+								   const SearchConstraints *constraints);
+
+/**
+ * Like findBestResults(), but every thread traverses the Trie replica of its own NUMA node.
+ *
+ * @param grid The game grid.
+ * @param replicas The per-node Trie replicas (see createTrieReplicas()).
+ * @param maxWordLength The maximum allowed word length.
+ * @param maxSwaps The maximum amount of swaps.
+ * @return An array of maxSwaps + 1 WordResults, with a NULL word where nothing was found.
+ */
+WordResult* findBestResultsReplicated(const Grid *grid, const TrieReplicas *replicas, int maxWordLength,
+									  int maxSwaps);
+
+/**
+ * Like findBestResults(), but overlaps the search with a dictionary that is still loading.
+ *
+ * Start cells are searched letter by letter as the loader publishes each first-letter
+ * subtrie, with the letters on the board built first. The loader still has to be
+ * finished with finishDictionaryLoad() afterwards.
+ *
+ * @param grid The game grid.
+ * @param loader The dictionary loader from startDictionaryLoad().
+ * @param maxWordLength The maximum allowed word length (at most the loader's).
+ * @param maxSwaps The maximum amount of swaps.
+ * @return An array of maxSwaps + 1 WordResults, with a NULL word where nothing was found.
+ */
+WordResult* findBestResultsWhileLoading(const Grid *grid, DictionaryLoader *loader, int maxWordLength, int maxSwaps);
+
+/**
+ * Creates reusable search buffers for findBestWords().
+ *
+ * @param gridSize The size of the grids that will be searched.
+ * @param maxWordLength The maximum allowed word length.
+ * @param maxSwaps The maximum amount of swaps.
+ * @return A pointer to the newly created SearchScratch.
+ */
+SearchScratch* createSearchScratch(int gridSize, int maxWordLength, int maxSwaps);
+
+/**
+ * Frees the buffers of a SearchScratch.
+ *
+ * @param scratch Pointer to the SearchScratch to be freed.
+ */
+void freeSearchScratch(SearchScratch *scratch);
+
+/**
+ * Frees the scratch space that findWords() and the findBestResults() family keep per
+ * thread between solves. Must not run concurrently with a search; later searches
+ * allocate new scratch space.
+ */
+void freeThreadScratch(void);
+
+/**
+ * Finds only the highest scoring word for each number of swaps, on the calling thread.
+ *
+ * Unlike findWords(), nothing is allocated per solve, which makes this suitable for
+ * tight loops of many solves (each caller thread owning its own scratch).
+ *
+ * @param grid The game grid.
+ * @param trie The Trie containing the dictionary.
+ * @param maxWordLength The maximum allowed word length (at most the scratch's).
+ * @param maxSwaps The maximum amount of swaps (at most the scratch's).
+ * @param scratch The search buffers, which also hold the returned results.
+ * @return An array of maxSwaps + 1 WordResults owned by the scratch, with score 0 where nothing was found.
+ */
+const WordResult* findBestWords(const Grid *grid, TrieNode *trie, int maxWordLength, int maxSwaps, SearchScratch *scratch);
+
 /**
  * Frees the memory allocated for the dynamic array of WordResults.
  *
@@ -50,6 +215,62 @@ void freeDynamicWordArray(DynamicWordArray *dwa);
  */
 void freeWordResult(WordResult *wr);
 
+/**
+ * Creates a deep copy of a WordResult.
+ *
+ * @param wr Pointer to the WordResult to copy.
+ * @return The copy, which must be released with freeWordResult().
+ */
+WordResult copyWordResult(const WordResult *wr);
+
+/**
+ * Selects the highest scoring word for each number of swaps.
+ *
+ * The selected results are deep copies, so the DynamicWordArray can be freed independently.
+ *
+ * @param words The words found by findWords().
+ * @param maxSwaps The maximum amount of swaps.
+ * @return An array of maxSwaps + 1 WordResults, with a NULL word where nothing was found.
+ */
+WordResult* selectBestResults(const DynamicWordArray *words, int maxSwaps);
+
+/**
+ * Merges a thread's best words into a shared array of best results.
+ *
+ * Callers running in parallel must serialize calls (e.g. with omp critical).
+ *
+ * @param bestResults The shared array of maxSwaps + 1 best results, updated with deep copies.
+ * @param best The thread's best words, with score 0 where nothing was found.
+ * @param maxSwaps The maximum amount of swaps.
+ */
+void mergeBestWords(WordResult *bestResults, const WordResult *best, int maxSwaps);
+
+/**
+ * Enables or disables the reachability memo for subsequent searches (enabled by default).
+ *
+ * The memo records, per search, which (trie node, cell, swaps left) states cannot lead to
+ * any word even when cells may be reused, and cuts those branches off. It is only used
+ * when swaps are allowed.
+ *
+ * @param enabled Whether to use the memo.
+ */
+void setReachabilityMemo(bool enabled);
+
+/**
+ * Returns the counters accumulated by all searches since the previous call, and resets them.
+ *
+ * @return The search counters.
+ */
+SearchStats takeSearchStats(void);
+
+/**
+ * Frees an array of best results returned by selectBestResults().
+ *
+ * @param bestResults The array of best results.
+ * @param maxSwaps The maximum amount of swaps.
+ */
+void freeBestResults(WordResult *bestResults, int maxSwaps);
+
 /**
  * Calculates the score for a given word based on its positions in the grid.
  *